@@ -0,0 +1,137 @@
+#include "CellCache.h"
+
+#include <QString>
+
+#include <algorithm>
+
+namespace
+{
+    uint64_t mix(uint64_t x)
+    {
+        x ^= x >> 33;
+        x *= 0xff51afd7ed558ccdULL;
+        x ^= x >> 33;
+        x *= 0xc4ceb9fe1a85ec53ULL;
+        x ^= x >> 33;
+        return x;
+    }
+}
+
+CellCache::CellCache(size_t budget)
+{
+    setBudget(budget);
+}
+
+void CellCache::setBudget(size_t budget)
+{
+    m_budget = budget;
+
+    // number of sets is a power of two
+    size_t sets = 1;
+    while (sets * 2 * WAYS * ENTRY_ESTIMATE <= budget)
+        sets *= 2;
+
+    m_slots = std::vector<Slot>(sets * WAYS);
+    m_setMask = sets - 1;
+    m_entries = 0;
+    m_payload = 0;
+}
+
+void CellCache::clear()
+{
+    for (auto& slot : m_slots) {
+        slot.stamp = 0;
+        slot.value.clear();
+    }
+    m_entries = 0;
+    m_payload = 0;
+}
+
+void CellCache::trim(size_t target)
+{
+    if (m_payload <= target)
+        return;
+
+    std::vector<Slot*> used;
+    used.reserve(m_entries);
+    for (auto& slot : m_slots) {
+        if (slot.stamp && payload(slot.value))
+            used.push_back(&slot);
+    }
+    std::sort(used.begin(), used.end(), [](const Slot* a, const Slot* b) { return a->stamp < b->stamp; });
+
+    for (Slot* slot : used) {
+        if (m_payload <= target)
+            break;
+        m_payload -= payload(slot->value);
+        slot->stamp = 0;
+        slot->value.clear();
+        --m_entries;
+        ++m_evictions;
+    }
+}
+
+CellCache::Slot* CellCache::set(uint64_t key)
+{
+    return &m_slots[(mix(key) & m_setMask) * WAYS];
+}
+
+const QVariant* CellCache::find(size_t row, size_t column)
+{
+    const uint64_t key = makeKey(row, column);
+    Slot* slots = set(key);
+
+    for (size_t i = 0; i < WAYS; ++i) {
+        if (slots[i].stamp && slots[i].key == key) {
+            slots[i].stamp = ++m_clock;
+            ++m_hits;
+            return &slots[i].value;
+        }
+    }
+
+    ++m_misses;
+    return nullptr;
+}
+
+void CellCache::insert(size_t row, size_t column, const QVariant& value)
+{
+    // huge cells would crowd out everything else, they are rebuilt on demand
+    const size_t size = payload(value);
+    if (size > m_budget / MAX_ENTRY_SHARE)
+        return;
+
+    const uint64_t key = makeKey(row, column);
+    Slot* slots = set(key);
+
+    // reuse the slot of the same key, an empty one or the oldest one
+    Slot* victim = &slots[0];
+    for (size_t i = 0; i < WAYS; ++i) {
+        Slot* slot = &slots[i];
+        if (slot->stamp && slot->key == key) {
+            victim = slot;
+            break;
+        }
+        if (slot->stamp < victim->stamp)
+            victim = slot;
+    }
+
+    if (victim->stamp) {
+        m_payload -= payload(victim->value);
+        if (victim->key != key)
+            ++m_evictions;
+    } else {
+        ++m_entries;
+    }
+
+    victim->key = key;
+    victim->stamp = ++m_clock;
+    victim->value = value;
+    m_payload += size;
+}
+
+size_t CellCache::payload(const QVariant& value)
+{
+    if (value.typeId() == QMetaType::QString)
+        return size_t(value.toString().capacity()) * sizeof(QChar);
+    return 0;
+}
@@ -0,0 +1,65 @@
+#pragma once
+
+#include "constants.h"
+
+#include <QVariant>
+
+#include <cstdint>
+#include <vector>
+
+// Fixed capacity cache of formatted table cells keyed by (row, column id).
+// Slots are grouped in small sets, a full set evicts its least recently used slot,
+// so lookups and inserts never allocate besides the cached value itself.
+class CellCache
+{
+public:
+    explicit CellCache(size_t budget = CELL_CACHE_BUDGET);
+
+    const QVariant* find(size_t row, size_t column);
+    void insert(size_t row, size_t column, const QVariant& value);
+    void clear();
+    // drop least recently used values until they take at most `target` bytes
+    void trim(size_t target);
+
+    void setBudget(size_t budget);
+    size_t budget() const { return m_budget; }
+
+    size_t hits() const { return m_hits; }
+    size_t misses() const { return m_misses; }
+    size_t evictions() const { return m_evictions; }
+    double hitRate() const { return m_hits + m_misses ? double(m_hits) / double(m_hits + m_misses) : 0.0; }
+    void resetCounters() { m_hits = m_misses = m_evictions = 0; }
+
+    size_t entries() const { return m_entries; }
+    size_t capacity() const { return m_slots.size(); }
+    size_t memoryUsage() const { return m_slots.size() * sizeof(Slot) + m_payload; }
+    // bytes of cached values, the part trim() can release; the slots are fixed
+    size_t valueBytes() const { return m_payload; }
+
+private:
+    static constexpr size_t WAYS = 4;
+    static constexpr size_t ENTRY_ESTIMATE = 128; // slot plus a typical short string
+    static constexpr size_t MAX_ENTRY_SHARE = 1024; // a single cell takes at most this part of the budget
+
+    struct Slot
+    {
+        uint64_t key;
+        uint64_t stamp;   // 0 for an empty slot, larger is more recent
+        QVariant value;
+    };
+
+    size_t m_budget;
+    std::vector<Slot> m_slots;
+    size_t m_setMask = 0;
+    uint64_t m_clock = 0;
+    size_t m_entries = 0;
+    size_t m_payload = 0;
+
+    size_t m_hits = 0;
+    size_t m_misses = 0;
+    size_t m_evictions = 0;
+
+    Slot* set(uint64_t key);
+    static uint64_t makeKey(size_t row, size_t column) { return (uint64_t(row) << 32) | uint32_t(column); }
+    static size_t payload(const QVariant& value);
+};
@@ -0,0 +1,101 @@
+#include "ColumnStats.h"
+#include "json.h"
+#include "constants.h"
+
+#include <algorithm>
+#include <cstring>
+
+void ColumnStats::add(const rapidjson::Value* value)
+{
+    records++;
+
+    if (!value) {
+        missing++;
+        return;
+    }
+
+    // values are counted by their text, numbers and strings alike
+    std::string text;
+    std::string_view view;
+
+    if (value->IsNull()) {
+        nulls++;
+        view = "null";
+    } else if (value->IsBool()) {
+        booleans++;
+        view = value->GetBool() ? "true" : "false";
+    } else if (value->IsNumber()) {
+        double number = value->GetDouble();
+        if (numbers++ == 0) {
+            min = max = number;
+        } else {
+            min = std::min(min, number);
+            max = std::max(max, number);
+        }
+        sum += number;
+        digest.add(number);
+
+        text = toJsonString(*value);
+        view = text;
+    } else if (value->IsString()) {
+        strings++;
+        view = std::string_view(value->GetString(), value->GetStringLength());
+    } else {
+        if (value->IsObject())
+            objects++;
+        else
+            arrays++;
+
+        text = toJsonString(*value, MAX_JSON_STRING_LENGTH);
+        view = text;
+    }
+
+    uint64_t hash = hashBytes(view);
+    distinct.add(hash);
+    topValues.add(view, hash);
+}
+
+void ColumnStats::merge(const ColumnStats& other)
+{
+    if (other.numbers) {
+        min = numbers ? std::min(min, other.min) : other.min;
+        max = numbers ? std::max(max, other.max) : other.max;
+    }
+
+    records += other.records;
+    missing += other.missing;
+    nulls += other.nulls;
+    booleans += other.booleans;
+    numbers += other.numbers;
+    strings += other.strings;
+    objects += other.objects;
+    arrays += other.arrays;
+    sum += other.sum;
+
+    distinct.merge(other.distinct);
+    topValues.merge(other.topValues);
+    digest.merge(other.digest);
+}
+
+std::vector<ColumnStats::Bin> ColumnStats::histogram(size_t bins) const
+{
+    std::vector<Bin> result;
+    if (!numbers || bins == 0)
+        return result;
+
+    if (max == min) {
+        result.push_back(Bin{min, max, double(numbers)});
+        return result;
+    }
+
+    const double width = (max - min) / bins;
+    double previous = 0;
+    for (size_t i = 0; i < bins; ++i) {
+        double from = min + i * width;
+        double to = (i + 1 == bins) ? max : from + width;
+        double cdf = (i + 1 == bins) ? 1.0 : digest.cdf(to);
+        result.push_back(Bin{from, to, (cdf - previous) * numbers});
+        previous = cdf;
+    }
+    return result;
+}
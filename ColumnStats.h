@@ -0,0 +1,41 @@
+#pragma once
+
+#include "Sketches.h"
+
+#include <rapidjson/document.h>
+
+#include <cstddef>
+#include <string>
+
+// Summary of the values of one column. Filled per chunk of records and merged.
+struct ColumnStats
+{
+    size_t records = 0;
+    size_t missing = 0;
+    size_t nulls = 0;
+    size_t booleans = 0;
+    size_t numbers = 0;
+    size_t strings = 0;
+    size_t objects = 0;
+    size_t arrays = 0;
+
+    double min = 0;
+    double max = 0;
+    double sum = 0;
+
+    HyperLogLog distinct;
+    TopValues topValues;
+    TDigest digest;
+
+    // `value` is null when the record doesn't have the column
+    void add(const rapidjson::Value* value);
+    void merge(const ColumnStats& other);
+
+    struct Bin
+    {
+        double from;
+        double to;
+        double count;
+    };
+    std::vector<Bin> histogram(size_t bins) const;
+};
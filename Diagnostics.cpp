@@ -0,0 +1,257 @@
+#include "Diagnostics.h"
+#include "JsonFile.h"
+#include "CellCache.h"
+
+#include <rapidjson/prettywriter.h>
+#include <rapidjson/stringbuffer.h>
+
+#include <sys/mman.h>
+#include <sys/resource.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <bit>
+#include <vector>
+
+namespace diagnostics
+{
+    size_t shard()
+    {
+        // threads take shards round robin, a shared shard only costs some contention
+        static std::atomic<size_t> next{0};
+        thread_local size_t index = next.fetch_add(1, std::memory_order_relaxed) % SHARDS;
+        return index;
+    }
+
+    uint64_t Counter::value() const
+    {
+        uint64_t total = 0;
+        for (const auto& shard : m_shards)
+            total += shard.value.load(std::memory_order_relaxed);
+        return total;
+    }
+
+    void Counter::reset()
+    {
+        for (auto& shard : m_shards)
+            shard.value.store(0, std::memory_order_relaxed);
+    }
+
+    void Histogram::record(uint64_t nanoseconds)
+    {
+        size_t bucket = std::min<size_t>(BUCKETS - 1, std::bit_width(nanoseconds));
+        auto& shard = m_shards[diagnostics::shard()];
+        shard.counts[bucket].fetch_add(1, std::memory_order_relaxed);
+        shard.sum.fetch_add(nanoseconds, std::memory_order_relaxed);
+    }
+
+    Histogram::Snapshot Histogram::snapshot() const
+    {
+        Snapshot result;
+        for (const auto& shard : m_shards) {
+            for (size_t i = 0; i < BUCKETS; ++i) {
+                uint64_t count = shard.counts[i].load(std::memory_order_relaxed);
+                result.counts[i] += count;
+                result.count += count;
+            }
+            result.sum += shard.sum.load(std::memory_order_relaxed);
+        }
+        return result;
+    }
+
+    void Histogram::reset()
+    {
+        for (auto& shard : m_shards) {
+            for (auto& count : shard.counts)
+                count.store(0, std::memory_order_relaxed);
+            shard.sum.store(0, std::memory_order_relaxed);
+        }
+    }
+
+    uint64_t Histogram::Snapshot::percentile(double p) const
+    {
+        if (!count)
+            return 0;
+
+        uint64_t rank = static_cast<uint64_t>(p * (count - 1)) + 1;
+        uint64_t seen = 0;
+        for (size_t i = 0; i < BUCKETS; ++i) {
+            seen += counts[i];
+            if (seen >= rank)
+                return i ? (uint64_t(1) << i) - 1 : 0;
+        }
+        return uint64_t(1) << (BUCKETS - 1);
+    }
+
+    Metrics& metrics()
+    {
+        static Metrics instance;
+        return instance;
+    }
+
+    void reset()
+    {
+        auto& m = metrics();
+        for (Counter* counter : {&m.indexedFiles, &m.indexedBytes, &m.indexedRecords, &m.indexNs,
+                                 &m.parsedRecords, &m.parsedBytes, &m.parseErrors,
+                                 &m.documentHits, &m.documentMisses,
+                                 &m.searches, &m.searchedBytes, &m.searchNs,
+                                 &m.treeModels, &m.treeItems})
+            counter->reset();
+        m.parseLatency.reset();
+    }
+
+    namespace
+    {
+        using Writer = rapidjson::PrettyWriter<rapidjson::StringBuffer>;
+
+        void field(Writer& writer, const char* name, uint64_t value)
+        {
+            writer.Key(name);
+            writer.Uint64(value);
+        }
+
+        void field(Writer& writer, const char* name, double value)
+        {
+            writer.Key(name);
+            writer.Double(value);
+        }
+
+        double rate(uint64_t amount, uint64_t nanoseconds)
+        {
+            return nanoseconds ? amount * 1e9 / nanoseconds : 0.0;
+        }
+
+        double ratio(uint64_t part, uint64_t total)
+        {
+            return total ? double(part) / total : 0.0;
+        }
+
+        // pages of the mapping currently in memory
+        uint64_t residentBytes(std::string_view mapping)
+        {
+            if (mapping.empty())
+                return 0;
+
+            const size_t page = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+            auto start = reinterpret_cast<uintptr_t>(mapping.data()) & ~(page - 1);
+            auto end = reinterpret_cast<uintptr_t>(mapping.data() + mapping.size());
+            size_t pages = (end - start + page - 1) / page;
+
+            std::vector<unsigned char> resident(pages);
+            if (mincore(reinterpret_cast<void*>(start), end - start, resident.data()) != 0)
+                return 0;
+
+            uint64_t count = 0;
+            for (unsigned char flags : resident)
+                count += flags & 1;
+            return std::min<uint64_t>(count * page, mapping.size());
+        }
+    }
+
+    std::string report(const JsonFile* file, const CellCache* cells, const MemoryBreakdown* memory)
+    {
+        const auto& m = metrics();
+        rapidjson::StringBuffer buffer;
+        Writer writer(buffer);
+
+        writer.StartObject();
+
+        writer.Key("index");
+        writer.StartObject();
+        field(writer, "files", m.indexedFiles.value());
+        field(writer, "bytes", m.indexedBytes.value());
+        field(writer, "records", m.indexedRecords.value());
+        field(writer, "seconds", m.indexNs.value() / 1e9);
+        field(writer, "mb_per_s", rate(m.indexedBytes.value(), m.indexNs.value()) / 1e6);
+        writer.EndObject();
+
+        const auto latency = m.parseLatency.snapshot();
+        writer.Key("parse");
+        writer.StartObject();
+        field(writer, "records", m.parsedRecords.value());
+        field(writer, "bytes", m.parsedBytes.value());
+        field(writer, "errors", m.parseErrors.value());
+        field(writer, "mb_per_s", rate(m.parsedBytes.value(), latency.sum) / 1e6);
+        field(writer, "mean_ns", latency.mean());
+        field(writer, "p50_ns", latency.percentile(0.50));
+        field(writer, "p90_ns", latency.percentile(0.90));
+        field(writer, "p99_ns", latency.percentile(0.99));
+        writer.Key("histogram"); // records per latency bucket, up to 2^i ns
+        writer.StartArray();
+        size_t last = Histogram::BUCKETS;
+        while (last > 0 && !latency.counts[last - 1])
+            --last;
+        for (size_t i = 0; i < last; ++i)
+            writer.Uint64(latency.counts[i]);
+        writer.EndArray();
+        writer.EndObject();
+
+        writer.Key("caches");
+        writer.StartObject();
+        field(writer, "document_hits", m.documentHits.value());
+        field(writer, "document_misses", m.documentMisses.value());
+        field(writer, "document_hit_rate", ratio(m.documentHits.value(), m.documentHits.value() + m.documentMisses.value()));
+        if (cells) {
+            field(writer, "cell_hits", uint64_t(cells->hits()));
+            field(writer, "cell_misses", uint64_t(cells->misses()));
+            field(writer, "cell_evictions", uint64_t(cells->evictions()));
+            field(writer, "cell_hit_rate", cells->hitRate());
+            field(writer, "cell_entries", uint64_t(cells->entries()));
+            field(writer, "cell_bytes", uint64_t(cells->memoryUsage()));
+        }
+        writer.EndObject();
+
+        writer.Key("search");
+        writer.StartObject();
+        field(writer, "searches", m.searches.value());
+        field(writer, "bytes", m.searchedBytes.value());
+        field(writer, "mb_per_s", rate(m.searchedBytes.value(), m.searchNs.value()) / 1e6);
+        writer.EndObject();
+
+        writer.Key("tree");
+        writer.StartObject();
+        field(writer, "models", m.treeModels.value());
+        field(writer, "items_allocated", m.treeItems.value());
+        writer.EndObject();
+
+        writer.Key("memory");
+        writer.StartObject();
+        if (file) {
+            writer.Key("format");
+            writer.String(formatName(file->format()));
+            field(writer, "skipped_ranges", uint64_t(file->skipped().size()));
+            field(writer, "mapped_bytes", uint64_t(file->contents().size()));
+            field(writer, "resident_bytes", residentBytes(file->contents()));
+            field(writer, "records", uint64_t(file->size()));
+            field(writer, "shapes", uint64_t(file->shapes().size()));
+            field(writer, "keys", uint64_t(file->topLevelKeys().size()));
+        }
+        rusage usage{};
+        getrusage(RUSAGE_SELF, &usage);
+        field(writer, "peak_rss_kb", uint64_t(usage.ru_maxrss));
+        writer.EndObject();
+
+        if (memory) {
+            uint64_t total = 0;
+            writer.Key("governor");
+            writer.StartObject();
+            field(writer, "budget", memory->budget);
+            field(writer, "limit", memory->limit);
+            field(writer, "pressure_events", memory->pressureEvents);
+            field(writer, "shrinks", memory->shrinks);
+            writer.Key("caches");
+            writer.StartObject();
+            for (const auto& [name, bytes] : memory->consumers) {
+                field(writer, name.c_str(), bytes);
+                total += bytes;
+            }
+            writer.EndObject();
+            field(writer, "total", total);
+            writer.EndObject();
+        }
+
+        writer.EndObject();
+        return std::string(buffer.GetString(), buffer.GetSize());
+    }
+}
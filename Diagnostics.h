@@ -0,0 +1,141 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+class JsonFile;
+class CellCache;
+
+// Always-on counters of the core paths. Every thread adds to its own shard with
+// relaxed atomics, shards are summed only when the numbers are read.
+namespace diagnostics
+{
+    constexpr size_t SHARDS = 16;
+
+    // shard of the calling thread
+    size_t shard();
+
+    class Counter
+    {
+    public:
+        void add(uint64_t value = 1) { m_shards[shard()].value.fetch_add(value, std::memory_order_relaxed); }
+        uint64_t value() const;
+        void reset();
+
+    private:
+        struct alignas(64) Shard
+        {
+            std::atomic<uint64_t> value{0};
+        };
+        std::array<Shard, SHARDS> m_shards;
+    };
+
+    // latencies in power of two buckets of nanoseconds
+    class Histogram
+    {
+    public:
+        static constexpr size_t BUCKETS = 40; // up to ~18 minutes
+
+        struct Snapshot
+        {
+            std::array<uint64_t, BUCKETS> counts{};
+            uint64_t count = 0;
+            uint64_t sum = 0;
+
+            // upper bound of the bucket holding the percentile
+            uint64_t percentile(double p) const;
+            double mean() const { return count ? double(sum) / count : 0.0; }
+        };
+
+        void record(uint64_t nanoseconds);
+        Snapshot snapshot() const;
+        void reset();
+
+    private:
+        struct alignas(64) Shard
+        {
+            std::array<std::atomic<uint64_t>, BUCKETS> counts{};
+            std::atomic<uint64_t> sum{0};
+        };
+        std::array<Shard, SHARDS> m_shards;
+    };
+
+    class Stopwatch
+    {
+    public:
+        Stopwatch() : m_start(std::chrono::steady_clock::now()) {}
+
+        uint64_t elapsed() const
+        {
+            return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - m_start).count();
+        }
+
+    private:
+        std::chrono::steady_clock::time_point m_start;
+    };
+
+    // adds the lifetime of the scope to a counter
+    class ScopedTimer
+    {
+    public:
+        explicit ScopedTimer(Counter& counter) : m_counter(counter) {}
+        ~ScopedTimer() { m_counter.add(m_watch.elapsed()); }
+
+        ScopedTimer(const ScopedTimer&) = delete;
+        ScopedTimer& operator=(const ScopedTimer&) = delete;
+
+    private:
+        Counter& m_counter;
+        Stopwatch m_watch;
+    };
+
+    struct Metrics
+    {
+        // JsonFile::open
+        Counter indexedFiles;
+        Counter indexedBytes;
+        Counter indexedRecords;
+        Counter indexNs;
+
+        // record parsing, on any thread
+        Counter parsedRecords;
+        Counter parsedBytes;
+        Counter parseErrors;
+        Histogram parseLatency;
+
+        // JsonFile::line finding the record already parsed
+        Counter documentHits;
+        Counter documentMisses;
+
+        // table search
+        Counter searches;
+        Counter searchedBytes;
+        Counter searchNs;
+
+        // tree view
+        Counter treeModels;
+        Counter treeItems;
+    };
+
+    Metrics& metrics();
+    void reset();
+
+    // state of the MemoryGovernor
+    struct MemoryBreakdown
+    {
+        uint64_t budget = 0;
+        uint64_t limit = 0;
+        uint64_t pressureEvents = 0;
+        uint64_t shrinks = 0;
+        std::vector<std::pair<std::string, uint64_t>> consumers; // name, bytes
+    };
+
+    // JSON report of the counters, plus the state of the open file, the table cache
+    // and the memory governor when given
+    std::string report(const JsonFile* file = nullptr, const CellCache* cells = nullptr, const MemoryBreakdown* memory = nullptr);
+}
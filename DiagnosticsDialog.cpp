@@ -0,0 +1,61 @@
+#include "DiagnosticsDialog.h"
+#include "Diagnostics.h"
+
+#include <QApplication>
+#include <QClipboard>
+#include <QDialogButtonBox>
+#include <QHeaderView>
+#include <QPushButton>
+#include <QVBoxLayout>
+
+DiagnosticsDialog::DiagnosticsDialog(const JsonFile* jsonFile, const JsonTableModel* tableModel, const MemoryGovernor* governor, QWidget* parent)
+    : QDialog(parent), m_jsonFile(jsonFile), m_tableModel(tableModel), m_governor(governor), m_view(new QTreeView(this))
+{
+    setWindowTitle(tr("Diagnostics"));
+    resize(480, 560);
+
+    m_view->setUniformRowHeights(true);
+
+    auto* buttons = new QDialogButtonBox(QDialogButtonBox::Close, this);
+    auto* refreshButton = buttons->addButton(tr("&Refresh"), QDialogButtonBox::ActionRole);
+    auto* copyButton = buttons->addButton(tr("&Copy JSON"), QDialogButtonBox::ActionRole);
+
+    auto* layout = new QVBoxLayout(this);
+    layout->addWidget(m_view);
+    layout->addWidget(buttons);
+
+    connect(buttons, &QDialogButtonBox::rejected, this, &QDialog::reject);
+    connect(refreshButton, &QPushButton::clicked, this, &DiagnosticsDialog::refresh);
+    connect(copyButton, &QPushButton::clicked, this, [this]() {
+        QApplication::clipboard()->setText(QString::fromStdString(m_report));
+    });
+
+    refresh();
+}
+
+DiagnosticsDialog::~DiagnosticsDialog()
+{
+    // the model refers to m_report
+    m_view->setModel(nullptr);
+    delete m_model;
+}
+
+void DiagnosticsDialog::refresh()
+{
+    m_view->setModel(nullptr);
+    delete m_model;
+    m_model = nullptr;
+
+    const CellCache* cells = m_tableModel ? &m_tableModel->cellCache() : nullptr;
+    const auto memory = m_governor ? m_governor->breakdown() : diagnostics::MemoryBreakdown();
+    m_report = diagnostics::report(m_jsonFile && m_jsonFile->size() ? m_jsonFile : nullptr, cells, m_governor ? &memory : nullptr);
+
+    auto document = std::make_unique<rapidjson::Document>();
+    std::vector<JsonSpan> spans;
+    parseWithSpans(m_report, *document, spans);
+
+    m_model = new JsonTreeModel(std::move(document), std::move(spans), m_report);
+    m_view->setModel(m_model);
+    m_view->expandAll();
+    m_view->header()->resizeSection(0, 200);
+}
@@ -0,0 +1,31 @@
+#pragma once
+
+#include "JsonFile.h"
+#include "JsonTableModel.h"
+#include "JsonTreeModel.h"
+#include "MemoryGovernor.h"
+
+#include <QDialog>
+#include <QTreeView>
+
+#include <string>
+
+// Shows the diagnostics report as a tree, refreshed on demand.
+class DiagnosticsDialog : public QDialog
+{
+    Q_OBJECT
+
+public:
+    DiagnosticsDialog(const JsonFile* jsonFile, const JsonTableModel* tableModel, const MemoryGovernor* governor, QWidget* parent = nullptr);
+    ~DiagnosticsDialog() override;
+
+    void refresh();
+
+private:
+    const JsonFile* m_jsonFile;
+    const JsonTableModel* m_tableModel;
+    const MemoryGovernor* m_governor;
+    QTreeView* m_view;
+    JsonTreeModel* m_model = nullptr;
+    std::string m_report; // text of m_model
+};
@@ -0,0 +1,160 @@
+#include "ErrorPanel.h"
+#include "Locale.h"
+
+#include <rapidjson/reader.h>
+#include <rapidjson/memorystream.h>
+#include <rapidjson/error/en.h>
+
+#include <QVBoxLayout>
+#include <QHeaderView>
+#include <QtConcurrent/QtConcurrent>
+
+#include <algorithm>
+
+namespace
+{
+    const size_t MIN_CHUNK_RECORDS = 4096;
+    const size_t MAX_CHUNKS = 256;
+    const int MAX_LISTED = 10000;       // errors shown in the list, all are counted
+
+    struct Chunk
+    {
+        size_t first;
+        size_t last;
+    };
+
+    enum Column
+    {
+        OffsetColumn,
+        RecordColumn,
+        MessageColumn,
+    };
+}
+
+ErrorPanel::ErrorPanel(JsonFile* jsonFile, QWidget* parent)
+    : QWidget(parent), m_jsonFile(jsonFile)
+{
+    m_title = new QLabel(this);
+    m_title->setWordWrap(true);
+
+    m_progress = new QProgressBar(this);
+    m_progress->hide();
+
+    m_view = new QTreeWidget(this);
+    m_view->setColumnCount(3);
+    m_view->setHeaderLabels({"Offset", "Record", "Error"});
+    m_view->setRootIsDecorated(false);
+    m_view->setUniformRowHeights(true);
+    m_view->header()->setSectionResizeMode(QHeaderView::ResizeToContents);
+
+    auto* layout = new QVBoxLayout(this);
+    layout->setContentsMargins(2, 2, 2, 2);
+    layout->addWidget(m_title);
+    layout->addWidget(m_progress);
+    layout->addWidget(m_view);
+
+    connect(&m_watcher, &QFutureWatcher<std::vector<Error>>::resultReadyAt, this, &ErrorPanel::onChunkReady);
+    connect(&m_watcher, &QFutureWatcher<std::vector<Error>>::finished, this, &ErrorPanel::onFinished);
+    connect(m_view, &QTreeWidget::itemActivated, this, [this](QTreeWidgetItem* item) {
+        emit jumpRequested(item->data(OffsetColumn, Qt::UserRole).toULongLong(),
+                           item->data(MessageColumn, Qt::UserRole).toULongLong(),
+                           item->data(RecordColumn, Qt::UserRole).toULongLong());
+    });
+}
+
+ErrorPanel::~ErrorPanel()
+{
+    cancel();
+}
+
+void ErrorPanel::cancel()
+{
+    if (m_future.isRunning()) {
+        m_future.cancel();
+        m_future.waitForFinished();
+    }
+}
+
+void ErrorPanel::scan()
+{
+    cancel();
+
+    // the indexer already knows what it skipped
+    m_errors.clear();
+    const size_t records = m_jsonFile->size();
+    for (const auto& skipped : m_jsonFile->skipped())
+        m_errors.push_back(Error{skipped.offset, skipped.length, records, QString("Not a JSON value, %1 bytes skipped").arg(locale.toString(qulonglong(skipped.length)))});
+
+    const size_t chunkSize = std::max(MIN_CHUNK_RECORDS, (records + MAX_CHUNKS - 1) / MAX_CHUNKS);
+    QList<Chunk> chunks;
+    for (size_t first = 0; first < records; first += chunkSize)
+        chunks.append(Chunk{first, std::min(records, first + chunkSize)});
+
+    m_progress->setRange(0, static_cast<int>(chunks.size()));
+    m_progress->setValue(0);
+    m_progress->setVisible(!chunks.isEmpty());
+
+    // records are only matched by brackets when indexing, a SAX pass without a DOM validates them
+    const JsonFile* jsonFile = m_jsonFile;
+    m_future = QtConcurrent::mapped(chunks, [jsonFile](const Chunk& chunk) {
+        std::vector<Error> errors;
+        rapidjson::Reader reader;
+        rapidjson::BaseReaderHandler<> handler;
+        for (size_t row = chunk.first; row < chunk.last; ++row) {
+            auto text = jsonFile->lineText(row);
+            rapidjson::MemoryStream stream(text.data(), text.size());
+            auto result = reader.Parse(stream, handler);
+            if (result.IsError())
+                errors.push_back(Error{jsonFile->lineOffset(row) + result.Offset(), 1, row, QString::fromUtf8(rapidjson::GetParseError_En(result.Code()))});
+        }
+        return errors;
+    });
+
+    m_watcher.setFuture(m_future);
+    refresh();
+}
+
+void ErrorPanel::onChunkReady(int index)
+{
+    const auto& errors = m_future.resultAt(index);
+    m_errors.insert(m_errors.end(), errors.begin(), errors.end());
+    m_progress->setValue(m_progress->value() + 1);
+    if (!errors.empty())
+        refresh();
+}
+
+void ErrorPanel::onFinished()
+{
+    m_progress->hide();
+    refresh();
+}
+
+void ErrorPanel::refresh()
+{
+    std::sort(m_errors.begin(), m_errors.end(), [](const Error& a, const Error& b) { return a.offset < b.offset; });
+
+    const size_t records = m_jsonFile->size();
+    if (m_errors.empty())
+        m_title->setText(m_future.isRunning() ? "Validating records..." : "No errors");
+    else
+        m_title->setText(QString("%1 errors, double-click to show one").arg(locale.toString(qulonglong(m_errors.size()))));
+
+    m_view->clear();
+    QList<QTreeWidgetItem*> items;
+    const int listed = std::min<int>(MAX_LISTED, static_cast<int>(m_errors.size()));
+    for (int i = 0; i < listed; ++i) {
+        const Error& error = m_errors[i];
+        auto* item = new QTreeWidgetItem({
+            locale.toString(qulonglong(error.offset)),
+            error.record < records ? locale.toString(qulonglong(error.record + 1)) : QString("-"),
+            error.message
+        });
+        item->setData(OffsetColumn, Qt::UserRole, qulonglong(error.offset));
+        item->setData(RecordColumn, Qt::UserRole, qulonglong(error.record));
+        item->setData(MessageColumn, Qt::UserRole, qulonglong(error.length));
+        items.append(item);
+    }
+    m_view->addTopLevelItems(items);
+
+    emit errorsChanged(static_cast<int>(m_errors.size()));
+}
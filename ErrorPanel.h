@@ -0,0 +1,54 @@
+#pragma once
+
+#include "JsonFile.h"
+
+#include <QWidget>
+#include <QLabel>
+#include <QProgressBar>
+#include <QTreeWidget>
+#include <QFuture>
+#include <QFutureWatcher>
+
+#include <vector>
+
+// Bytes the indexer skipped and records that are not valid JSON, validated in
+// parallel chunks of records after a file is opened. Activating an error asks to
+// jump to its offset.
+class ErrorPanel : public QWidget
+{
+    Q_OBJECT
+
+public:
+    struct Error
+    {
+        size_t offset;
+        size_t length;
+        size_t record;    // JsonFile::size() for skipped bytes
+        QString message;
+    };
+
+    explicit ErrorPanel(JsonFile* jsonFile, QWidget* parent = nullptr);
+    ~ErrorPanel() override;
+
+    void scan();
+    void cancel();
+
+signals:
+    void jumpRequested(qulonglong offset, qulonglong length, qulonglong record);
+    // number of errors found so far
+    void errorsChanged(int count);
+
+private:
+    JsonFile* m_jsonFile;
+    QLabel* m_title;
+    QProgressBar* m_progress;
+    QTreeWidget* m_view;
+
+    QFuture<std::vector<Error>> m_future;
+    QFutureWatcher<std::vector<Error>> m_watcher;
+    std::vector<Error> m_errors;
+
+    void onChunkReady(int index);
+    void onFinished();
+    void refresh();
+};
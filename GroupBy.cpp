@@ -0,0 +1,290 @@
+#include "GroupBy.h"
+#include "constants.h"
+#include "json.h"
+
+#include <QRegularExpression>
+
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+    const char KEY_SEPARATOR = '\x1f';
+    const char* MISSING_KEY = "(missing)";
+
+    void keyText(const rapidjson::Value* value, std::string& out)
+    {
+        if (!value)
+            out = MISSING_KEY;
+        else if (value->IsString())
+            out.assign(value->GetString(), value->GetStringLength());
+        else
+            out = toJsonString(*value, MAX_JSON_STRING_LENGTH);
+    }
+
+    // pNN is a percentile: p5 -> 0.05, p50 -> 0.5, p100 -> 1; p999, p9999 -> 0.999, 0.9999
+    std::optional<double> quantileOf(const QString& digits)
+    {
+        bool ok = false;
+        const uint value = digits.toUInt(&ok);
+        if (!ok || value == 0)
+            return std::nullopt;
+        if (value <= 100)
+            return value / 100.0;
+        if (digits.size() > 2 && digits.count('9') == digits.size())
+            return value / std::pow(10.0, digits.size());
+        return std::nullopt;
+    }
+}
+
+std::optional<GroupByQuery> GroupByQuery::parse(const QString& keys, const QString& aggregates, QString* error)
+{
+    GroupByQuery query;
+
+    for (const auto& text : keys.split(',', Qt::SkipEmptyParts)) {
+        auto path = JsonPath::compile(text, error);
+        if (!path)
+            return std::nullopt;
+        query.keys.push_back(std::move(*path));
+    }
+
+    if (query.keys.empty()) {
+        if (error)
+            *error = "No group keys";
+        return std::nullopt;
+    }
+
+    static const QRegularExpression pattern("^\\s*(\\w+)\\s*(?:\\((.*)\\))?\\s*$");
+
+    for (const auto& text : aggregates.split(',', Qt::SkipEmptyParts)) {
+        auto match = pattern.match(text);
+        if (!match.hasMatch()) {
+            if (error)
+                *error = QString("Invalid aggregate '%1'").arg(text.trimmed());
+            return std::nullopt;
+        }
+
+        Aggregate aggregate;
+        aggregate.text = text.trimmed();
+        const QString function = match.captured(1).toLower();
+        const QString argument = match.captured(2);
+
+        if (function == "count") {
+            aggregate.function = Function::Count;
+            query.aggregates.push_back(std::move(aggregate));
+            continue;
+        }
+
+        if (function == "sum")
+            aggregate.function = Function::Sum;
+        else if (function == "min")
+            aggregate.function = Function::Min;
+        else if (function == "max")
+            aggregate.function = Function::Max;
+        else if (function == "avg")
+            aggregate.function = Function::Avg;
+        else if (function.size() > 1 && function[0] == 'p' && function[1].isDigit()) {
+            auto quantile = quantileOf(function.mid(1));
+            if (!quantile) {
+                if (error)
+                    *error = QString("Invalid percentile '%1', use p1 to p100 or p999").arg(function);
+                return std::nullopt;
+            }
+            aggregate.function = Function::Quantile;
+            aggregate.quantile = *quantile;
+        } else {
+            if (error)
+                *error = QString("Unknown aggregate '%1'").arg(function);
+            return std::nullopt;
+        }
+
+        aggregate.path = JsonPath::compile(argument, error);
+        if (!aggregate.path)
+            return std::nullopt;
+
+        query.aggregates.push_back(std::move(aggregate));
+    }
+
+    if (query.aggregates.empty()) {
+        Aggregate count;
+        count.function = Function::Count;
+        count.text = "count";
+        query.aggregates.push_back(std::move(count));
+    }
+
+    return query;
+}
+
+GroupTable::GroupTable(const GroupByQuery* query)
+    : m_query(query)
+{
+    newGroup(m_other);
+    m_other.key.assign(query->keys.size(), "(other)");
+    m_other.other = true;
+    m_bytes = groupCost(std::string());
+}
+
+void GroupTable::newGroup(Group& group) const
+{
+    group.states.resize(m_query->aggregates.size());
+    for (size_t i = 0; i < m_query->aggregates.size(); ++i) {
+        if (m_query->aggregates[i].function == GroupByQuery::Function::Quantile)
+            group.states[i].digest.emplace();
+    }
+}
+
+size_t GroupTable::groupCost(const std::string& id) const
+{
+    // map node, the id and the key parts, aggregate states with their digests
+    size_t bytes = sizeof(std::pair<const std::string, Group>) + 2 * sizeof(void*) + 2 * id.size()
+        + m_query->keys.size() * sizeof(std::string)
+        + m_query->aggregates.size() * sizeof(State);
+    for (const auto& aggregate : m_query->aggregates) {
+        if (aggregate.function == GroupByQuery::Function::Quantile)
+            bytes += TDigest::memoryBound();
+    }
+    return bytes;
+}
+
+GroupTable::Group& GroupTable::find(const std::string& id, const std::vector<std::string>* key)
+{
+    auto it = m_groups.find(id);
+    if (it != m_groups.end())
+        return it->second;
+
+    // over budget, the rest of the keys is approximated by a single group
+    const size_t cost = groupCost(id);
+    if (m_bytes + cost > GROUP_BY_MEMORY_BUDGET)
+        return m_other;
+
+    m_bytes += cost;
+    Group& group = m_groups[id];
+    newGroup(group);
+    if (key)
+        group.key = *key;
+    return group;
+}
+
+void GroupTable::addRow(Group& group, size_t row)
+{
+    group.records++;
+    // rows are only for navigation, they have their own budget so they never fold groups
+    if (group.rows.size() < GROUP_BY_MAX_ROWS && m_rowBytes + sizeof(size_t) <= GROUP_BY_ROWS_BUDGET) {
+        group.rows.push_back(row);
+        m_rowBytes += sizeof(size_t);
+    }
+}
+
+void GroupTable::add(size_t row, const rapidjson::Value& record)
+{
+    m_key.resize(m_query->keys.size());
+    m_scratch.clear();
+    for (size_t i = 0; i < m_key.size(); ++i) {
+        keyText(m_query->keys[i].extract(record), m_key[i]);
+        if (i)
+            m_scratch.push_back(KEY_SEPARATOR);
+        m_scratch += m_key[i];
+    }
+
+    Group& group = find(m_scratch, &m_key);
+    addRow(group, row);
+
+    for (size_t i = 0; i < m_query->aggregates.size(); ++i) {
+        const auto& aggregate = m_query->aggregates[i];
+        if (!aggregate.path)
+            continue;
+
+        const rapidjson::Value* value = aggregate.path->extract(record);
+        if (!value || !value->IsNumber())
+            continue;
+
+        const double number = value->GetDouble();
+        State& state = group.states[i];
+        state.min = state.count ? std::min(state.min, number) : number;
+        state.max = state.count ? std::max(state.max, number) : number;
+        state.sum += number;
+        state.count++;
+        if (state.digest)
+            state.digest->add(number);
+    }
+}
+
+void GroupTable::mergeGroup(Group& target, const Group& source)
+{
+    target.records += source.records;
+    for (size_t row : source.rows) {
+        if (target.rows.size() >= GROUP_BY_MAX_ROWS || m_rowBytes + sizeof(size_t) > GROUP_BY_ROWS_BUDGET)
+            break;
+        target.rows.push_back(row);
+        m_rowBytes += sizeof(size_t);
+    }
+
+    for (size_t i = 0; i < target.states.size(); ++i) {
+        State& state = target.states[i];
+        const State& other = source.states[i];
+        if (!other.count)
+            continue;
+
+        state.min = state.count ? std::min(state.min, other.min) : other.min;
+        state.max = state.count ? std::max(state.max, other.max) : other.max;
+        state.sum += other.sum;
+        state.count += other.count;
+        if (state.digest && other.digest)
+            state.digest->merge(*other.digest);
+    }
+}
+
+void GroupTable::merge(const GroupTable& other)
+{
+    if (!m_query) {
+        *this = other;
+        return;
+    }
+
+    for (const auto& [id, group] : other.m_groups)
+        mergeGroup(find(id, &group.key), group);
+
+    mergeGroup(m_other, other.m_other);
+}
+
+std::vector<const GroupTable::Group*> GroupTable::groups() const
+{
+    std::vector<const Group*> result;
+    result.reserve(m_groups.size() + 1);
+    for (const auto& [id, group] : m_groups)
+        result.push_back(&group);
+
+    if (m_other.records)
+        result.push_back(&m_other);
+    return result;
+}
+
+double GroupTable::value(const GroupByQuery::Aggregate& aggregate, const Group& group, size_t index)
+{
+    const State& state = group.states[index];
+
+    switch (aggregate.function) {
+        case GroupByQuery::Function::Count: return static_cast<double>(group.records);
+        case GroupByQuery::Function::Sum: return state.sum;
+        case GroupByQuery::Function::Min: return state.count ? state.min : NAN;
+        case GroupByQuery::Function::Max: return state.count ? state.max : NAN;
+        case GroupByQuery::Function::Avg: return state.count ? state.sum / state.count : NAN;
+        case GroupByQuery::Function::Quantile: return state.digest ? state.digest->quantile(aggregate.quantile) : NAN;
+    }
+    return NAN;
+}
+
+GroupTable groupRecords(const JsonFile* jsonFile, const GroupByQuery* query, size_t first, size_t last)
+{
+    GroupTable table(query);
+
+    for (size_t row = first; row < last; ++row) {
+        auto text = jsonFile->lineText(row);
+        rapidjson::Document doc;
+        doc.Parse(text.data(), text.size());
+        if (!doc.HasParseError())
+            table.add(row, doc);
+    }
+
+    return table;
+}
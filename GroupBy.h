@@ -0,0 +1,97 @@
+#pragma once
+
+#include "JsonFile.h"
+#include "JsonPath.h"
+#include "Sketches.h"
+
+#include <QString>
+
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Group-by query over all records: keys are field paths, aggregates are
+// count, sum(path), min(path), max(path), avg(path) and pNN(path) quantiles.
+struct GroupByQuery
+{
+    enum class Function
+    {
+        Count,
+        Sum,
+        Min,
+        Max,
+        Avg,
+        Quantile,
+    };
+
+    struct Aggregate
+    {
+        Function function;
+        std::optional<JsonPath> path; // none for count
+        double quantile = 0;
+        QString text;
+    };
+
+    std::vector<JsonPath> keys;
+    std::vector<Aggregate> aggregates;
+
+    // keys: `status, request.host`, aggregates: `count, sum(bytes), p99(latency_ms)`
+    static std::optional<GroupByQuery> parse(const QString& keys, const QString& aggregates, QString* error = nullptr);
+};
+
+// groups of a set of records, mergeable so that chunks can be aggregated in parallel
+class GroupTable
+{
+public:
+    struct State
+    {
+        size_t count = 0;   // numeric values seen
+        double sum = 0;
+        double min = 0;
+        double max = 0;
+        std::optional<TDigest> digest;
+    };
+
+    struct Group
+    {
+        std::vector<std::string> key;
+        size_t records = 0;
+        std::vector<State> states;
+        std::vector<size_t> rows; // first matching rows, at most GROUP_BY_MAX_ROWS and within GROUP_BY_ROWS_BUDGET
+        bool other = false;       // folded groups beyond the budget
+    };
+
+    GroupTable() = default;
+    explicit GroupTable(const GroupByQuery* query);
+
+    void add(size_t row, const rapidjson::Value& record);
+    void merge(const GroupTable& other);
+
+    // groups without particular order
+    std::vector<const Group*> groups() const;
+    // groups beyond GROUP_BY_MEMORY_BUDGET were folded into one
+    bool approximate() const { return m_other.records != 0; }
+    // estimated bytes of groups, rows and digests
+    size_t memoryUsage() const { return m_bytes + m_rowBytes; }
+
+    static double value(const GroupByQuery::Aggregate& aggregate, const Group& group, size_t index);
+
+private:
+    const GroupByQuery* m_query = nullptr;
+    std::unordered_map<std::string, Group> m_groups;
+    Group m_other;
+    size_t m_bytes = 0;     // of groups, within GROUP_BY_MEMORY_BUDGET
+    size_t m_rowBytes = 0;  // of rows, within GROUP_BY_ROWS_BUDGET
+    std::vector<std::string> m_key;  // scratch buffers
+    std::string m_scratch;
+
+    Group& find(const std::string& id, const std::vector<std::string>* key);
+    void newGroup(Group& group) const;
+    size_t groupCost(const std::string& id) const;
+    void addRow(Group& group, size_t row);
+    void mergeGroup(Group& target, const Group& source);
+};
+
+// run the query over records [first, last) of the file, safe to call from worker threads
+GroupTable groupRecords(const JsonFile* jsonFile, const GroupByQuery* query, size_t first, size_t last);
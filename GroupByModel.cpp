@@ -0,0 +1,119 @@
+#include "GroupByModel.h"
+#include "Locale.h"
+
+#include <algorithm>
+#include <cmath>
+
+void GroupByModel::setResult(std::shared_ptr<const GroupByQuery> query, GroupTable table)
+{
+    beginResetModel();
+    m_query = std::move(query);
+    m_table = std::move(table);
+    m_groups = m_table.groups();
+    endResetModel();
+
+    // largest groups first
+    sort(static_cast<int>(keyCount()), Qt::DescendingOrder);
+}
+
+void GroupByModel::clear()
+{
+    beginResetModel();
+    m_groups.clear();
+    m_table = GroupTable();
+    m_query.reset();
+    endResetModel();
+}
+
+int GroupByModel::rowCount(const QModelIndex& parent) const
+{
+    return parent.isValid() ? 0 : static_cast<int>(m_groups.size());
+}
+
+int GroupByModel::columnCount(const QModelIndex& parent) const
+{
+    return parent.isValid() || !m_query ? 0 : static_cast<int>(m_query->keys.size() + m_query->aggregates.size());
+}
+
+double GroupByModel::value(const GroupTable::Group& group, int column) const
+{
+    size_t index = column - keyCount();
+    return GroupTable::value(m_query->aggregates[index], group, index);
+}
+
+QVariant GroupByModel::data(const QModelIndex& index, int role) const
+{
+    if (!index.isValid())
+        return QVariant();
+
+    const auto& group = *m_groups[index.row()];
+    const int column = index.column();
+    const bool isKey = column < static_cast<int>(keyCount());
+
+    if (role == Qt::TextAlignmentRole)
+        return static_cast<int>((isKey ? Qt::AlignLeft : Qt::AlignRight) | Qt::AlignVCenter);
+
+    if (role != Qt::DisplayRole)
+        return QVariant();
+
+    if (isKey) {
+        const auto& key = group.key[column];
+        return QString::fromUtf8(key.data(), key.size());
+    }
+
+    double result = value(group, column);
+    if (std::isnan(result))
+        return QString();
+
+    if (m_query->aggregates[column - keyCount()].function == GroupByQuery::Function::Count)
+        return locale.toString(qulonglong(result));
+
+    return locale.toString(result);
+}
+
+QVariant GroupByModel::headerData(int section, Qt::Orientation orientation, int role) const
+{
+    if (role != Qt::DisplayRole || orientation != Qt::Horizontal || !m_query)
+        return QVariant();
+
+    if (section < static_cast<int>(keyCount()))
+        return m_query->keys[section].text();
+
+    return m_query->aggregates[section - keyCount()].text;
+}
+
+void GroupByModel::sort(int column, Qt::SortOrder order)
+{
+    if (!m_query || column < 0 || column >= columnCount())
+        return;
+
+    emit layoutAboutToBeChanged();
+
+    const bool ascending = order == Qt::AscendingOrder;
+    if (column < static_cast<int>(keyCount())) {
+        std::stable_sort(m_groups.begin(), m_groups.end(), [&](const auto* a, const auto* b) {
+            return ascending ? a->key[column] < b->key[column] : b->key[column] < a->key[column];
+        });
+    } else {
+        // missing values go last in either order
+        std::stable_sort(m_groups.begin(), m_groups.end(), [&](const auto* a, const auto* b) {
+            double x = value(*a, column);
+            double y = value(*b, column);
+            if (std::isnan(x) || std::isnan(y))
+                return !std::isnan(x) && std::isnan(y);
+            return ascending ? x < y : y < x;
+        });
+    }
+
+    emit layoutChanged();
+}
+
+std::vector<size_t> GroupByModel::rows(int row) const
+{
+    if (row < 0 || row >= static_cast<int>(m_groups.size()))
+        return {};
+
+    std::vector<size_t> result = m_groups[row]->rows;
+    std::sort(result.begin(), result.end());
+    return result;
+}
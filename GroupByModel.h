@@ -0,0 +1,37 @@
+#pragma once
+
+#include "GroupBy.h"
+
+#include <QAbstractTableModel>
+
+#include <memory>
+
+// result of a group-by query: key columns followed by aggregate columns
+class GroupByModel : public QAbstractTableModel
+{
+    Q_OBJECT
+
+public:
+    using QAbstractTableModel::QAbstractTableModel;
+
+    void setResult(std::shared_ptr<const GroupByQuery> query, GroupTable table);
+    void clear();
+
+    int rowCount(const QModelIndex& parent = QModelIndex()) const override;
+    int columnCount(const QModelIndex& parent = QModelIndex()) const override;
+    QVariant data(const QModelIndex& index, int role) const override;
+    QVariant headerData(int section, Qt::Orientation orientation, int role) const override;
+    void sort(int column, Qt::SortOrder order) override;
+
+    // records of the group, sorted, at most GROUP_BY_MAX_ROWS of them
+    std::vector<size_t> rows(int row) const;
+    bool approximate() const { return m_table.approximate(); }
+
+private:
+    std::shared_ptr<const GroupByQuery> m_query;
+    GroupTable m_table;
+    std::vector<const GroupTable::Group*> m_groups;
+
+    size_t keyCount() const { return m_query ? m_query->keys.size() : 0; }
+    double value(const GroupTable::Group& group, int column) const;
+};
@@ -0,0 +1,156 @@
+#include "GroupByPanel.h"
+#include "Locale.h"
+
+#include <QFormLayout>
+#include <QVBoxLayout>
+#include <QHBoxLayout>
+#include <QPushButton>
+#include <QHeaderView>
+#include <QtConcurrent/QtConcurrent>
+
+namespace
+{
+    const size_t MIN_CHUNK_RECORDS = 4096;
+    const size_t MAX_CHUNKS = 256;
+
+    struct Chunk
+    {
+        size_t first;
+        size_t last;
+    };
+}
+
+GroupByPanel::GroupByPanel(JsonFile* jsonFile, QWidget* parent)
+    : QWidget(parent), m_jsonFile(jsonFile)
+{
+    m_keys = new QLineEdit(this);
+    m_keys->setPlaceholderText("status, request.host");
+
+    m_aggregates = new QLineEdit(this);
+    m_aggregates->setPlaceholderText("count, sum(bytes), avg(latency_ms), p99(latency_ms)");
+
+    auto* runButton = new QPushButton("Run", this);
+
+    m_status = new QLabel(this);
+    m_status->setWordWrap(true);
+
+    m_progress = new QProgressBar(this);
+    m_progress->hide();
+
+    m_model = new GroupByModel(this);
+    m_view = new QTableView(this);
+    m_view->setModel(m_model);
+    m_view->setSortingEnabled(true);
+    m_view->setSelectionBehavior(QAbstractItemView::SelectRows);
+    m_view->setSelectionMode(QAbstractItemView::SingleSelection);
+    m_view->horizontalHeader()->setSortIndicatorShown(true);
+
+    auto* form = new QFormLayout;
+    form->addRow("Group by", m_keys);
+    form->addRow("Aggregates", m_aggregates);
+
+    auto* buttons = new QHBoxLayout;
+    buttons->addWidget(m_status, 1);
+    buttons->addWidget(runButton);
+
+    auto* layout = new QVBoxLayout(this);
+    layout->setContentsMargins(2, 2, 2, 2);
+    layout->addLayout(form);
+    layout->addLayout(buttons);
+    layout->addWidget(m_progress);
+    layout->addWidget(m_view);
+
+    connect(runButton, &QPushButton::clicked, this, &GroupByPanel::run);
+    connect(m_keys, &QLineEdit::returnPressed, this, &GroupByPanel::run);
+    connect(m_aggregates, &QLineEdit::returnPressed, this, &GroupByPanel::run);
+    connect(m_view, &QTableView::activated, this, &GroupByPanel::onActivated);
+    connect(m_model, &QAbstractItemModel::layoutChanged, this, [this]() { m_activeGroup = -1; });
+
+    connect(&m_watcher, &QFutureWatcher<GroupTable>::progressRangeChanged, m_progress, &QProgressBar::setRange);
+    connect(&m_watcher, &QFutureWatcher<GroupTable>::progressValueChanged, m_progress, &QProgressBar::setValue);
+    connect(&m_watcher, &QFutureWatcher<GroupTable>::finished, this, &GroupByPanel::onFinished);
+}
+
+GroupByPanel::~GroupByPanel()
+{
+    cancel();
+}
+
+void GroupByPanel::cancel()
+{
+    if (m_future.isRunning()) {
+        m_future.cancel();
+        m_future.waitForFinished();
+    }
+}
+
+void GroupByPanel::run()
+{
+    cancel();
+
+    QString error;
+    auto query = GroupByQuery::parse(m_keys->text(), m_aggregates->text(), &error);
+    if (!query) {
+        m_status->setText(error);
+        return;
+    }
+
+    m_model->clear();
+    m_activeGroup = -1;
+    m_query = std::make_shared<const GroupByQuery>(std::move(*query));
+
+    const size_t records = m_jsonFile->size();
+    const size_t chunkSize = std::max(MIN_CHUNK_RECORDS, (records + MAX_CHUNKS - 1) / MAX_CHUNKS);
+
+    QList<Chunk> chunks;
+    for (size_t first = 0; first < records; first += chunkSize)
+        chunks.append(Chunk{first, std::min(records, first + chunkSize)});
+
+    m_status->setText(QString("Grouping %1 records...").arg(locale.toString(qulonglong(records))));
+    m_progress->show();
+
+    // chunk tables are merged as they complete, the query outlives the run
+    const JsonFile* jsonFile = m_jsonFile;
+    auto queryRef = m_query;
+    m_future = QtConcurrent::mappedReduced<GroupTable>(chunks,
+        [jsonFile, queryRef](const Chunk& chunk) {
+            return groupRecords(jsonFile, queryRef.get(), chunk.first, chunk.last);
+        },
+        [](GroupTable& result, const GroupTable& chunk) {
+            result.merge(chunk);
+        },
+        QtConcurrent::UnorderedReduce);
+
+    m_watcher.setFuture(m_future);
+}
+
+void GroupByPanel::onFinished()
+{
+    m_progress->hide();
+    if (m_future.isCanceled())
+        return;
+
+    GroupTable table = m_future.resultCount() ? m_future.result() : GroupTable(m_query.get());
+    m_model->setResult(m_query, std::move(table));
+
+    QString status = QString("%1 groups").arg(locale.toString(m_model->rowCount()));
+    if (m_model->approximate())
+        status += QString(", groups beyond the %1 MB budget are folded into (other)").arg(locale.toString(qulonglong(GROUP_BY_MEMORY_BUDGET >> 20)));
+    m_status->setText(status);
+}
+
+void GroupByPanel::onActivated(const QModelIndex& index)
+{
+    auto rows = m_model->rows(index.row());
+    if (rows.empty())
+        return;
+
+    // activating the same group again moves to its next record
+    if (m_activeGroup == index.row())
+        m_activeRecord = (m_activeRecord + 1) % rows.size();
+    else
+        m_activeRecord = 0;
+
+    m_activeGroup = index.row();
+    emit rowRequested(static_cast<int>(rows[m_activeRecord]));
+}
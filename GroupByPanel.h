@@ -0,0 +1,53 @@
+#pragma once
+
+#include "JsonFile.h"
+#include "GroupBy.h"
+#include "GroupByModel.h"
+
+#include <QWidget>
+#include <QLineEdit>
+#include <QLabel>
+#include <QProgressBar>
+#include <QTableView>
+#include <QFuture>
+#include <QFutureWatcher>
+
+#include <memory>
+
+// Group-by query over all records. Chunks of records are aggregated in parallel
+// into their own group tables, which are merged into the result.
+class GroupByPanel : public QWidget
+{
+    Q_OBJECT
+
+public:
+    explicit GroupByPanel(JsonFile* jsonFile, QWidget* parent = nullptr);
+    ~GroupByPanel() override;
+
+    void run();
+    void cancel();
+
+signals:
+    // a group was activated, show one of its records
+    void rowRequested(int row);
+
+private:
+    JsonFile* m_jsonFile;
+    QLineEdit* m_keys;
+    QLineEdit* m_aggregates;
+    QLabel* m_status;
+    QProgressBar* m_progress;
+    QTableView* m_view;
+    GroupByModel* m_model;
+
+    std::shared_ptr<const GroupByQuery> m_query;
+    QFuture<GroupTable> m_future;
+    QFutureWatcher<GroupTable> m_watcher;
+
+    // position when cycling through records of a group
+    int m_activeGroup = -1;
+    size_t m_activeRecord = 0;
+
+    void onFinished();
+    void onActivated(const QModelIndex& index);
+};
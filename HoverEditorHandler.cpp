@@ -6,6 +6,13 @@
 #include <QMouseEvent>
 #include <QPlainTextEdit>
 
+void HoverEditorHandler::closeCurrent()
+{
+    if (currentIndex.isValid())
+        treeView->closePersistentEditor(currentIndex);
+    currentIndex = QPersistentModelIndex();
+}
+
 bool HoverEditorHandler::eventFilter(QObject* obj, QEvent* event)
 {
     if (!treeView || !treeView->model())
@@ -17,58 +24,40 @@ bool HoverEditorHandler::eventFilter(QObject* obj, QEvent* event)
 
         if (index.column() == TreeViewColumn::ValueColumn && index.isValid()) {
             if (index != currentIndex) {
-                if (currentIndex.isValid()) {
-                    QPlainTextEdit* editor = qobject_cast<QPlainTextEdit*>(treeView->indexWidget(currentIndex));
-
-                    if (editor) editor->setTextInteractionFlags(Qt::NoTextInteraction);
-            //         treeView->closePersistentEditor(currentIndex);
-                }
-
                 JsonTreeItem* item = JsonTreeItem::fromIndex(index);
+                if (!item->isMultiline() && !item->hasLargeText())
+                    return false; // the open editor stays, its selection can still be copied
 
-                if (item->isMultiline()) {
-                    treeView->openPersistentEditor(index);
-                    currentIndex = index;
-
-                    QPlainTextEdit* editor = qobject_cast<QPlainTextEdit*>(treeView->indexWidget(index));
-                    if (editor) {
-                        editor->setReadOnly(true);
-                        editor->setTextInteractionFlags(Qt::TextSelectableByMouse | Qt::TextSelectableByKeyboard);
-
-                        editor->setFocus(Qt::MouseFocusReason);
-
-                        // highlight the editor
-                        QPalette pal = editor->palette();
-
-                        // Use system's highlight color with low opacity blended into base
-                        QColor highlight = pal.color(QPalette::Highlight);
-                        QColor base = pal.color(QPalette::Base);
-
-                        // Blend 15% of highlight over base (semi-transparent effect)
-                        QColor blended = QColor(
-                            (base.red()   * 85 + highlight.red()   * 15) / 100,
-                            (base.green() * 85 + highlight.green() * 15) / 100,
-                            (base.blue()  * 85 + highlight.blue()  * 15) / 100
-                        );
-
-                        QPalette p = editor->palette();
-                        p.setColor(QPalette::Base, blended);
-                        editor->setPalette(p);
-
-                    }
-                }
-            }
-        } else {
-            if (currentIndex.isValid()) {
-                QPlainTextEdit* editor = qobject_cast<QPlainTextEdit*>(treeView->indexWidget(currentIndex));
+                // the delegate hands out the same editor again
+                closeCurrent();
+                treeView->openPersistentEditor(index);
+                currentIndex = index;
 
-            //     treeView->closePersistentEditor(currentIndex);
-                currentIndex = QModelIndex();
+                QWidget* widget = treeView->indexWidget(index);
+                if (widget)
+                    widget->setFocus(Qt::MouseFocusReason);
 
+                QPlainTextEdit* editor = qobject_cast<QPlainTextEdit*>(widget);
                 if (editor) {
-                    editor->setTextInteractionFlags(Qt::NoTextInteraction);
-                    editor->clearFocus();
-                    editor = nullptr;
+                    editor->setReadOnly(true);
+                    editor->setTextInteractionFlags(Qt::TextSelectableByMouse | Qt::TextSelectableByKeyboard);
+
+                    // highlight the editor, blended from the view's colors since the
+                    // recycled editor still carries the previous blend
+                    const QPalette viewPalette = treeView->palette();
+                    QColor highlight = viewPalette.color(QPalette::Highlight);
+                    QColor base = viewPalette.color(QPalette::Base);
+
+                    // Blend 15% of highlight over base (semi-transparent effect)
+                    QColor blended = QColor(
+                        (base.red()   * 85 + highlight.red()   * 15) / 100,
+                        (base.green() * 85 + highlight.green() * 15) / 100,
+                        (base.blue()  * 85 + highlight.blue()  * 15) / 100
+                    );
+
+                    QPalette p = editor->palette();
+                    p.setColor(QPalette::Base, blended);
+                    editor->setPalette(p);
                 }
             }
         }
@@ -3,8 +3,11 @@
 #include <QObject>
 #include <QTreeView>
 #include <QModelIndex>
+#include <QPersistentModelIndex>
 #include <QPlainTextEdit>
 
+// Opens the selectable editor on the multiline cell under the mouse.
+// The previous cell is closed first, so at most one editor exists.
 class HoverEditorHandler : public QObject
 {
     Q_OBJECT
@@ -17,5 +20,7 @@ protected:
 
 private:
     QTreeView* treeView;
-    QModelIndex currentIndex;
+    QPersistentModelIndex currentIndex;
+
+    void closeCurrent();
 };
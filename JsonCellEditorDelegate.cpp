@@ -1,7 +1,43 @@
 #include "JsonCellEditorDelegate.h"
+#include "JsonTreeModel.h"
+#include "LargeTextView.h"
+#include "constants.h"
+
+#include <QApplication>
+#include <QPainter>
+#include <QTextOption>
+
+namespace
+{
+    // cells painted with a cached layout, enough for a few screens of multiline values
+    constexpr int LAYOUT_CACHE_SIZE = 256;
+    constexpr int TEXT_MARGIN = 2;
+
+    int lineCount(const QModelIndex& index)
+    {
+        QVariant counted = index.data(JsonTreeModel::LineCountRole);
+        return counted.isValid() ? counted.toInt() : index.data(Qt::DisplayRole).toString().count('\n') + 1;
+    }
+}
+
+JsonCellEditorDelegate::JsonCellEditorDelegate(QObject* parent)
+    : QStyledItemDelegate(parent), m_layouts(LAYOUT_CACHE_SIZE)
+{
+}
 
 QWidget *JsonCellEditorDelegate::createEditor(QWidget *parent, const QStyleOptionViewItem &, const QModelIndex &index) const
 {
+    // large strings are shown in place, without a copy
+    if (index.data(JsonTreeModel::StringBytesRole).isValid())
+        return new LargeTextView(parent);
+
+    // reuse the shared editor, it is hidden rather than deleted when a cell is closed
+    if (m_editor && !m_editorInUse) {
+        m_editor->setParent(parent);
+        m_editorInUse = true;
+        return m_editor;
+    }
+
     QPlainTextEdit *editor = new QPlainTextEdit(parent);
     editor->setReadOnly(true);
     editor->setFrameStyle(QFrame::NoFrame);
@@ -23,11 +59,34 @@ QWidget *JsonCellEditorDelegate::createEditor(QWidget *parent, const QStyleOptio
     // pal.setColor(QPalette::HighlightedText, pal.color(QPalette::HighlightedText));
     // editor->setPalette(pal);
 
+    // a second cell edited at the same time gets a temporary editor
+    if (!m_editor) {
+        m_editor = editor;
+        m_editorInUse = true;
+    }
     return editor;
 }
 
+void JsonCellEditorDelegate::destroyEditor(QWidget *editor, const QModelIndex &index) const
+{
+    if (editor != m_editor) {
+        QStyledItemDelegate::destroyEditor(editor, index);
+        return;
+    }
+
+    // keep the widget, drop the text it holds
+    m_editor->hide();
+    m_editor->clear();
+    m_editorInUse = false;
+}
+
 void JsonCellEditorDelegate::setEditorData(QWidget *editor, const QModelIndex &index) const
 {
+    if (auto* view = qobject_cast<LargeTextView*>(editor)) {
+        view->setText(index.data(JsonTreeModel::StringBytesRole).toByteArray());
+        return;
+    }
+
     QString text = index.data(Qt::DisplayRole).toString();
     QPlainTextEdit *edit = qobject_cast<QPlainTextEdit *>(editor);
     if (edit) {
@@ -41,16 +100,103 @@ void JsonCellEditorDelegate::updateEditorGeometry(QWidget *editor, const QStyleO
     editor->setGeometry(option.rect);
 }
 
-QSize JsonCellEditorDelegate::sizeHint(const QStyleOptionViewItem& option, const QModelIndex& index) const
+void JsonCellEditorDelegate::watchModel(const QAbstractItemModel* model) const
+{
+    if (m_model == model)
+        return;
+
+    // items of a destroyed or reset model may share addresses with new ones
+    m_layouts.clear();
+    m_model = model;
+    if (m_watched.contains(model))
+        return;
+
+    m_watched.insert(model);
+    connect(model, &QObject::destroyed, this, [this, model]() {
+        m_watched.remove(model);
+        m_layouts.clear();
+    });
+    connect(model, &QAbstractItemModel::modelReset, this, [this]() { m_layouts.clear(); });
+}
+
+QTextLayout* JsonCellEditorDelegate::layout(const QStyleOptionViewItem& option, const QModelIndex& index, int width) const
 {
+    watchModel(index.model());
+
+    LayoutKey key{index.model(), index.internalId(), width};
+    if (QTextLayout* cached = m_layouts.object(key))
+        return cached;
+
+    // only the lines that fit in the cell are laid out
     QString text = index.data(Qt::DisplayRole).toString();
-    QFontMetrics fm(option.font);
+    int end = -1;
+    for (int line = 0; line < MAX_CELL_LINES; ++line) {
+        end = text.indexOf('\n', end + 1);
+        if (end < 0)
+            break;
+    }
+    if (end >= 0)
+        text.truncate(end);
+
+    auto* layout = new QTextLayout(text, option.font);
+    QTextOption textOption;
+    textOption.setWrapMode(QTextOption::WrapAtWordBoundaryOrAnywhere);
+    layout->setTextOption(textOption);
+
+    const qreal maxHeight = MAX_CELL_LINES * QFontMetricsF(option.font).lineSpacing();
+    qreal height = 0;
+    layout->beginLayout();
+    while (height < maxHeight) {
+        QTextLine line = layout->createLine();
+        if (!line.isValid())
+            break;
+        line.setLineWidth(width);
+        line.setPosition(QPointF(0, height));
+        height += line.height();
+    }
+    layout->endLayout();
+
+    m_layouts.insert(key, layout);
+    return layout;
+}
 
+void JsonCellEditorDelegate::paint(QPainter* painter, const QStyleOptionViewItem& option, const QModelIndex& index) const
+{
+    if (lineCount(index) <= 1) {
+        QStyledItemDelegate::paint(painter, option, index);
+        return;
+    }
+
+    // background, selection and focus without the text
+    QStyleOptionViewItem opt = option;
+    initStyleOption(&opt, index);
+    opt.text.clear();
+    const QWidget* widget = option.widget;
+    QStyle* style = widget ? widget->style() : QApplication::style();
+    style->drawControl(QStyle::CE_ItemViewItem, &opt, painter, widget);
+
+    QRect textRect = style->subElementRect(QStyle::SE_ItemViewItemText, &opt, widget)
+        .adjusted(TEXT_MARGIN, 0, -TEXT_MARGIN, 0);
+    if (textRect.width() <= 0)
+        return;
+
+    QTextLayout* text = layout(opt, index, textRect.width());
+
+    painter->save();
+    painter->setClipRect(textRect);
+    painter->setPen(opt.palette.color(opt.state & QStyle::State_Selected ? QPalette::HighlightedText : QPalette::Text));
+    text->draw(painter, textRect.topLeft());
+    painter->restore();
+}
+
+QSize JsonCellEditorDelegate::sizeHint(const QStyleOptionViewItem& option, const QModelIndex& index) const
+{
+    QFontMetrics fm(option.font);
     int lineHeight = fm.lineSpacing();
-    int maxLines = 20;  // limit to N lines
 
-    int lines = text.count('\n') + 1;
-    int height = qMin(lines, maxLines) * lineHeight + 4;
+    // the tree model counts lines once, other models get the text scanned
+    int lines = lineCount(index);
+    int height = qMin(lines, MAX_CELL_LINES) * lineHeight + 4;
 
     return QSize(option.rect.width(), height);
 }
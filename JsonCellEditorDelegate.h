@@ -3,17 +3,51 @@
 #include <QStyledItemDelegate>
 #include <QPlainTextEdit>
 #include <QStyleOptionViewItem>
+#include <QTextLayout>
+#include <QPointer>
+#include <QCache>
+#include <QSet>
 #include <QWidget>
 
+#include <memory>
+
+// Paints multiline values with cached text layouts, so no widget is needed to show them.
+// A single read-only editor is handed out for text selection and reused for every cell.
 class JsonCellEditorDelegate : public QStyledItemDelegate
 {
 public:
-    using QStyledItemDelegate::QStyledItemDelegate;
+    explicit JsonCellEditorDelegate(QObject* parent = nullptr);
 
     QWidget *createEditor(QWidget *parent, const QStyleOptionViewItem &, const QModelIndex &index) const override;
+    void destroyEditor(QWidget *editor, const QModelIndex &index) const override;
 
     void setEditorData(QWidget *editor, const QModelIndex &index) const override;
     void updateEditorGeometry(QWidget *editor, const QStyleOptionViewItem &option, const QModelIndex &) const override;
 
+    void paint(QPainter* painter, const QStyleOptionViewItem& option, const QModelIndex& index) const override;
     QSize sizeHint(const QStyleOptionViewItem& option, const QModelIndex& index) const override;
+
+private:
+    // layouts of recently painted cells, keyed by model, item and width
+    struct LayoutKey
+    {
+        const QAbstractItemModel* model;
+        quintptr item;
+        int width;
+
+        bool operator==(const LayoutKey& other) const
+        {
+            return model == other.model && item == other.item && width == other.width;
+        }
+    };
+    friend size_t qHash(const LayoutKey& key, size_t seed) { return qHashMulti(seed, key.model, key.item, key.width); }
+
+    mutable QCache<LayoutKey, QTextLayout> m_layouts;
+    mutable QPointer<QPlainTextEdit> m_editor;
+    mutable bool m_editorInUse = false;
+    mutable QPointer<const QAbstractItemModel> m_model;
+    mutable QSet<const QAbstractItemModel*> m_watched;
+
+    QTextLayout* layout(const QStyleOptionViewItem& option, const QModelIndex& index, int width) const;
+    void watchModel(const QAbstractItemModel* model) const;
 };
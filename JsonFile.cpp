@@ -1,6 +1,8 @@
 #include "JsonFile.h"
 
 #include "json.h"
+#include "Diagnostics.h"
+#include "constants.h"
 
 #include <rapidjson/reader.h>
 #include <rapidjson/document.h>
@@ -11,6 +13,26 @@
 #include <string_view>
 #include <cctype>
 #include <optional>
+#include <algorithm>
+
+#include <sys/stat.h>
+
+namespace
+{
+    // parse with the latency going to the diagnostics histogram
+    bool measuredParse(JsonFile::StringView text, rapidjson::Document& doc, std::vector<JsonSpan>& spans)
+    {
+        auto& metrics = diagnostics::metrics();
+        diagnostics::Stopwatch watch;
+        bool ok = parseWithSpans(text, doc, spans);
+        metrics.parseLatency.record(watch.elapsed());
+        metrics.parsedRecords.add();
+        metrics.parsedBytes.add(text.size());
+        if (!ok)
+            metrics.parseErrors.add();
+        return ok;
+    }
+}
 
 JsonFile::JsonFile()
 {
@@ -40,20 +62,38 @@ bool JsonFile::open(const QString& filename)
 
     lines.clear();
     lines.reserve(1000);
+    parsedOrder.clear();
+    parsedSize = 0;
+    shapeTable.resetCounts();
 
-    parseSequentialJson(this->dataView, [&](size_t index, StringView range) {
+    diagnostics::Stopwatch watch;
+
+    skippedRanges.clear();
+    dataFormat = detectJsonFormat(this->dataView);
+    splitJson(this->dataView, dataFormat, [&](size_t index, StringView range) {
         lines.push_back(Line{
             .index = index,
             .range = range,
-            .value = std::nullopt
+            .value = std::nullopt,
+            .spans = {},
+            .shape = ShapeTable::NO_SHAPE
         });
+    }, [&](size_t offset, size_t length) {
+        skippedRanges.push_back(Skipped{offset, length});
     });
 
-    // preload first lines
+    auto& metrics = diagnostics::metrics();
+    metrics.indexNs.add(watch.elapsed());
+    metrics.indexedFiles.add();
+    metrics.indexedBytes.add(size);
+    metrics.indexedRecords.add(lines.size());
+
+    // preload first lines, huge ones are only browsed through a structural index
     for (int i = 0; i < 10; ++i) {
         if (i == this->lines.size())
             break;
-        line(i);
+        if (lines[i].range.size() <= LAZY_DOCUMENT_BYTES)
+            line(i);
     }
 
     return true;
@@ -65,43 +105,130 @@ void JsonFile::close()
         file.unmap(mappedData);
         file.close();
     }
+
+    // lines refer to the mapping
+    lines.clear();
+    skippedRanges.clear();
+    dataFormat = JsonFormat::Lines;
+    parsedOrder.clear();
+    parsedSize = 0;
+    dataView = StringView();
+    mappedData = nullptr;
 }
 
 JsonFile::LineInfo JsonFile::line(size_t index)
 {
     auto& line = this->lines[index];
     if (line.value) {
+        diagnostics::metrics().documentHits.add();
         return LineInfo{
             .index = index,
             .size = line.range.size(),
             .text = line.range,
             .doc = *line.value,
-            .keysUpdated = false
+            .keysUpdated = false,
+            .source = JsonSource{line.range, &line.spans},
+            .shape = shapeOf(line)
         };
     }
 
+    diagnostics::metrics().documentMisses.add();
     rapidjson::Document doc;
-    doc.Parse(line.range.data(), line.range.size());
+    measuredParse(line.range, doc, line.spans);
+    return store(line, std::move(doc));
+}
+
+JsonFile::LineInfo JsonFile::adoptLine(size_t index, rapidjson::Document&& doc, std::vector<JsonSpan>&& spans)
+{
+    auto& line = this->lines[index];
+    if (line.value)
+        return this->line(index);
+
+    line.spans = std::move(spans);
+    return store(line, std::move(doc));
+}
+
+JsonFile::LineInfo JsonFile::store(Line& line, rapidjson::Document&& doc)
+{
     bool keysUpdated = false;
 
-    // update names
+    // update names and intern the key order of the record
     if (doc.IsObject()) {
+        shapeKeys.clear();
         for (auto it = doc.MemberBegin(); it != doc.MemberEnd(); ++it) {
-            QString key = QString::fromUtf8(it->name.GetString(), it->name.GetStringLength());
-            if (!keySet.contains(key)) {
-                keySet.insert(key);
-                discoveredKeys.push_back(key);
+            std::string_view name(it->name.GetString(), it->name.GetStringLength());
+            auto key = keyIds.find(name);
+            if (key == keyIds.end()) {
+                key = keyIds.emplace(std::string(name), static_cast<uint32_t>(discoveredKeys.size())).first;
+                discoveredKeys.push_back(QString::fromUtf8(name.data(), name.size()));
                 keysUpdated = true;
             }
+            shapeKeys.push_back(key->second);
         }
+        line.shape = shapeTable.intern(shapeKeys);
     }
 
     line.value = std::move(doc);
+    parsedSize += memoryOf(line);
+    parsedOrder.push_back(line.index);
     return LineInfo{
-        .index = index,
+        .index = line.index,
         .size = line.range.size(),
         .text = line.range,
         .doc = *line.value,
-        .keysUpdated = keysUpdated
+        .keysUpdated = keysUpdated,
+        .source = JsonSource{line.range, &line.spans},
+        .shape = shapeOf(line)
     };
 }
+
+size_t JsonFile::memoryOf(const Line& line)
+{
+    return const_cast<rapidjson::Document&>(*line.value).GetAllocator().Capacity()
+        + line.spans.capacity() * sizeof(JsonSpan);
+}
+
+void JsonFile::evictParsed(size_t target)
+{
+    // a line parsed again after eviction is queued twice, the stale entry finds it parsed
+    // and evicts it early, which is fine for a cache
+    while (parsedSize > target && !parsedOrder.empty()) {
+        auto& line = lines[parsedOrder.front()];
+        parsedOrder.pop_front();
+        if (!line.value)
+            continue;
+
+        parsedSize -= memoryOf(line);
+        line.value.reset();
+        line.spans = std::vector<JsonSpan>();
+        if (line.shape != ShapeTable::NO_SHAPE) {
+            shapeTable.release(line.shape);
+            line.shape = ShapeTable::NO_SHAPE;
+        }
+    }
+}
+
+bool JsonFile::isOpenFile(const QString& path) const
+{
+    struct stat open;
+    struct stat other;
+    if (handle() < 0 || ::fstat(handle(), &open) != 0 || ::stat(QFile::encodeName(path).constData(), &other) != 0)
+        return false;
+    return open.st_dev == other.st_dev && open.st_ino == other.st_ino;
+}
+
+size_t JsonFile::recordAt(size_t offset) const
+{
+    auto it = std::lower_bound(lines.begin(), lines.end(), offset, [this](const Line& line, size_t offset) {
+        return size_t(line.range.data() - dataView.data()) < offset;
+    });
+    return it - lines.begin();
+}
+
+bool JsonFile::parseLine(size_t index, rapidjson::Document& doc, std::vector<JsonSpan>& spans) const
+{
+    if (index >= lines.size())
+        return false;
+
+    return measuredParse(lines[index].range, doc, spans);
+}
@@ -4,10 +4,16 @@
 #include <QFile>
 #include <QString>
 
+#include "json.h"
+#include "JsonShape.h"
+
 #include <rapidjson/document.h>
 #include <string_view>
 #include <optional>
+#include <deque>
 #include <set>
+#include <string>
+#include <unordered_map>
 
 class JsonFile
 {
@@ -21,6 +27,8 @@ public:
         StringView text;
         const rapidjson::Document& doc;
         bool keysUpdated;
+        JsonSource source;
+        const JsonShape* shape; // null unless the record is an object
     };
 
     struct Line
@@ -28,9 +36,20 @@ public:
         size_t index;
         StringView range;
         std::optional<rapidjson::Document> value;
+        std::vector<JsonSpan> spans;
+        uint32_t shape;
+    };
+
+    // bytes the indexer couldn't match to a value and skipped
+    struct Skipped
+    {
+        size_t offset;
+        size_t length;
     };
 
     const std::vector<QString>& topLevelKeys() const { return discoveredKeys; }
+    // shapes of parsed records, for diagnostics
+    const ShapeTable& shapes() const { return shapeTable; }
 
     JsonFile();
     ~JsonFile();
@@ -50,6 +69,16 @@ public:
     }
 
     LineInfo line(size_t index);
+    // cache a line parsed elsewhere, e.g. by parseLine on a worker thread
+    LineInfo adoptLine(size_t index, rapidjson::Document&& doc, std::vector<JsonSpan>&& spans);
+    bool isParsed(size_t index) const { return index < lines.size() && lines[index].value.has_value(); }
+    // memory held by parsed records
+    size_t parsedBytes() const { return parsedSize; }
+    // drop parsed records, oldest first, until at most `target` bytes are left.
+    // References from earlier line() calls become invalid.
+    void evictParsed(size_t target);
+    // parse a line without caching it, safe to call from worker threads
+    bool parseLine(size_t index, rapidjson::Document& doc, std::vector<JsonSpan>& spans) const;
     StringView lineText(size_t index) const
     {
         if (index >= lines.size())
@@ -58,16 +87,57 @@ public:
         return lines[index].range;
     }
 
+    // position of the record in the file
+    size_t lineOffset(size_t index) const
+    {
+        return lines[index].range.data() - dataView.data();
+    }
+
+    // whole mapped file
+    StringView contents() const { return dataView; }
+    // layout detected on open, decides how records are split
+    JsonFormat format() const { return dataFormat; }
+    const std::vector<Skipped>& skipped() const { return skippedRanges; }
+    // first record starting at or after `offset`, size() when there is none
+    size_t recordAt(size_t offset) const;
+
+    // descriptor of the open file, -1 when closed
+    int handle() const { return file.handle(); }
+    // `path` names the open file, writing to it would truncate the mapping
+    bool isOpenFile(const QString& path) const;
+
 private:
     QFile file;
 
     StringView dataView;
     uchar * mappedData = nullptr;
     std::vector<Line> lines;
+    std::vector<Skipped> skippedRanges;
+    JsonFormat dataFormat = JsonFormat::Lines;
+
+    // Lazily discovered keys, the position in discoveredKeys is the column id
+    struct KeyHash
+    {
+        using is_transparent = void;
+        size_t operator()(std::string_view key) const { return std::hash<std::string_view>()(key); }
+    };
 
-    // Lazily discovered keys
     std::vector<QString> discoveredKeys;
-    QSet<QString> keySet;
+    std::unordered_map<std::string, uint32_t, KeyHash, std::equal_to<>> keyIds;
+
+    ShapeTable shapeTable;
+    std::vector<uint32_t> shapeKeys; // scratch buffer
+
+    std::deque<size_t> parsedOrder; // indexes of parsed lines, oldest first
+    size_t parsedSize = 0;
+
+    LineInfo store(Line& line, rapidjson::Document&& doc);
+    static size_t memoryOf(const Line& line);
+
+    const JsonShape* shapeOf(const Line& line) const
+    {
+        return line.shape == ShapeTable::NO_SHAPE ? nullptr : &shapeTable.shape(line.shape);
+    }
 
     // static std::vector<Line> parseSequentialJson(StringView data);
 };
@@ -0,0 +1,113 @@
+#include "JsonPath.h"
+
+#include <cctype>
+
+namespace
+{
+    bool fail(QString* error, const QString& message)
+    {
+        if (error)
+            *error = message;
+        return false;
+    }
+}
+
+std::optional<JsonPath> JsonPath::compile(const QString& text, QString* error)
+{
+    JsonPath path;
+    path.m_text = text.trimmed();
+
+    const std::string source = path.m_text.toStdString();
+    const char* p = source.c_str();
+    const char* end = p + source.size();
+
+    if (p == end) {
+        fail(error, "Path is empty");
+        return std::nullopt;
+    }
+
+    while (p < end) {
+        Step step;
+
+        if (*p == '[') {
+            ++p;
+            if (p < end && *p == '"') {
+                // quoted member name
+                ++p;
+                while (p < end && *p != '"') {
+                    if (*p == '\\' && p + 1 < end)
+                        ++p;
+                    step.name.push_back(*p++);
+                }
+                if (p == end || ++p == end || *p != ']') {
+                    fail(error, "Unterminated quoted name");
+                    return std::nullopt;
+                }
+            } else {
+                // array index
+                const char* digits = p;
+                uint64_t index = 0;
+                while (p < end && std::isdigit(static_cast<unsigned char>(*p)))
+                    index = index * 10 + (*p++ - '0');
+                if (p == digits || p == end || *p != ']' || index > UINT32_MAX) {
+                    fail(error, "Expected an index in brackets");
+                    return std::nullopt;
+                }
+                step.index = static_cast<rapidjson::SizeType>(index);
+                step.isIndex = true;
+            }
+            ++p; // skip ']'
+        } else {
+            while (p < end && *p != '.' && *p != '[')
+                step.name.push_back(*p++);
+            if (step.name.empty()) {
+                fail(error, "Empty member name");
+                return std::nullopt;
+            }
+        }
+
+        path.m_steps.push_back(std::move(step));
+
+        if (p < end && *p == '.') {
+            ++p;
+            if (p == end) {
+                fail(error, "Path ends with a dot");
+                return std::nullopt;
+            }
+        }
+    }
+
+    return path;
+}
+
+JsonPath JsonPath::member(const QString& name)
+{
+    JsonPath path;
+    path.m_text = name;
+    path.m_steps.push_back(Step{name.toStdString(), 0, false});
+    return path;
+}
+
+const rapidjson::Value* JsonPath::extract(const rapidjson::Value& root) const
+{
+    const rapidjson::Value* value = &root;
+
+    for (const auto& step : m_steps) {
+        if (step.isIndex) {
+            if (!value->IsArray() || step.index >= value->Size())
+                return nullptr;
+            value = &(*value)[step.index];
+        } else {
+            if (!value->IsObject())
+                return nullptr;
+            // constant string value, refers to the step name without copying
+            const rapidjson::Value name(rapidjson::StringRef(step.name.data(), static_cast<rapidjson::SizeType>(step.name.size())));
+            auto it = value->FindMember(name);
+            if (it == value->MemberEnd())
+                return nullptr;
+            value = &it->value;
+        }
+    }
+
+    return value;
+}
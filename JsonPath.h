@@ -0,0 +1,34 @@
+#pragma once
+
+#include <rapidjson/document.h>
+
+#include <QString>
+
+#include <optional>
+#include <string>
+#include <vector>
+
+// Path to a nested value, e.g. `request.headers.user-agent`, `items[0].id` or `ctx["trace.id"]`.
+// The path is compiled once, extracting does not allocate.
+class JsonPath
+{
+public:
+    static std::optional<JsonPath> compile(const QString& text, QString* error = nullptr);
+    // path to a top level member, the name is taken literally
+    static JsonPath member(const QString& name);
+
+    const rapidjson::Value* extract(const rapidjson::Value& root) const;
+
+    const QString& text() const { return m_text; }
+
+private:
+    struct Step
+    {
+        std::string name;               // member name, unless this is an index step
+        rapidjson::SizeType index = 0;
+        bool isIndex = false;
+    };
+
+    QString m_text;
+    std::vector<Step> m_steps;
+};
@@ -0,0 +1,55 @@
+#include "JsonShape.h"
+
+#include <algorithm>
+
+size_t ShapeTable::KeysHash::operator()(const std::vector<uint32_t>& keys) const
+{
+    // FNV-1a over column ids
+    uint64_t hash = 1469598103934665603ULL;
+    for (uint32_t key : keys) {
+        hash ^= key;
+        hash *= 1099511628211ULL;
+    }
+    return static_cast<size_t>(hash);
+}
+
+uint32_t ShapeTable::intern(const std::vector<uint32_t>& keys)
+{
+    auto it = m_index.find(keys);
+    if (it != m_index.end()) {
+        m_shapes[it->second].records++;
+        return it->second;
+    }
+
+    JsonShape shape;
+    shape.keys = keys;
+    shape.records = 1;
+
+    uint32_t maxKey = 0;
+    for (uint32_t key : keys)
+        maxKey = std::max(maxKey, key);
+
+    shape.slots.assign(keys.empty() ? 0 : maxKey + 1, -1);
+    for (size_t i = 0; i < keys.size(); ++i) {
+        // duplicated keys resolve to the first member, as FindMember does
+        if (shape.slots[keys[i]] < 0)
+            shape.slots[keys[i]] = static_cast<int32_t>(i);
+    }
+
+    uint32_t id = static_cast<uint32_t>(m_shapes.size());
+    m_shapes.push_back(std::move(shape));
+    m_index.emplace(keys, id);
+    return id;
+}
+
+void ShapeTable::resetCounts()
+{
+    for (auto& shape : m_shapes)
+        shape.records = 0;
+}
+
+void ShapeTable::clear()
+{
+    m_shapes.clear();
+    m_index.clear();
+}
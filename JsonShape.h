@@ -0,0 +1,42 @@
+#pragma once
+
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+// Ordered list of top level keys of a record. Records sharing a key order share a shape,
+// which maps column ids straight to member slots.
+struct JsonShape
+{
+    std::vector<uint32_t> keys;   // column ids in member order
+    std::vector<int32_t> slots;   // column id -> member index, -1 when absent
+    size_t records = 0;           // parsed records having this shape
+
+    int32_t slot(size_t column) const { return column < slots.size() ? slots[column] : -1; }
+};
+
+class ShapeTable
+{
+public:
+    static constexpr uint32_t NO_SHAPE = UINT32_MAX;
+
+    uint32_t intern(const std::vector<uint32_t>& keys);
+    // a record of the shape was dropped from memory
+    void release(uint32_t id) { m_shapes[id].records--; }
+
+    const JsonShape& shape(uint32_t id) const { return m_shapes[id]; }
+    const std::vector<JsonShape>& shapes() const { return m_shapes; }
+    size_t size() const { return m_shapes.size(); }
+
+    void resetCounts();
+    void clear();
+
+private:
+    struct KeysHash
+    {
+        size_t operator()(const std::vector<uint32_t>& keys) const;
+    };
+
+    std::vector<JsonShape> m_shapes;
+    std::unordered_map<std::vector<uint32_t>, uint32_t, KeysHash> m_index;
+};
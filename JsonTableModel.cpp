@@ -3,8 +3,10 @@
 
 #include "json.h"
 #include "Locale.h"
+#include "Diagnostics.h"
 
 #include <regex>
+#include <memory>
 
 #include <QTimer>
 #include <QtConcurrent/QtConcurrent>
@@ -25,7 +27,36 @@ int JsonTableModel::rowCount(const QModelIndex &) const
 
 int JsonTableModel::columnCount(const QModelIndex &) const
 {
-    return static_cast<int>(m_keys.size() + 2);
+    return static_cast<int>(m_keys.size()) + firstKeyColumn();
+}
+
+QVariant JsonTableModel::formatValue(const rapidjson::Value& val)
+{
+    if (val.IsNull())
+        return QString("null");
+    if (val.IsString()) {
+        // a cell can't show more anyway, keep huge strings out of the paint path
+        const char* str = val.GetString();
+        size_t length = val.GetStringLength();
+        if (length <= MAX_JSON_STRING_LENGTH)
+            return QString::fromUtf8(str, length);
+
+        // raw text like shorter strings, cut before a utf-8 sequence
+        length = MAX_JSON_STRING_LENGTH;
+        while (length > 0 && (static_cast<unsigned char>(str[length]) & 0xC0) == 0x80)
+            --length;
+        return QString::fromUtf8(str, length) + QStringLiteral("\u2026");
+    }
+    if (val.IsInt64())
+        return numberFormatter.toString(val.GetInt64());
+    if (val.IsUint64())
+        return numberFormatter.toString(val.GetUint64());
+    if (val.IsBool())
+        return val.GetBool() ? "true" : "false";
+    if (val.IsDouble())
+        return numberFormatter.toString(val.GetDouble());
+
+    return QString::fromUtf8(toJsonString(val, MAX_JSON_STRING_LENGTH));
 }
 
 QVariant JsonTableModel::data(const QModelIndex &index, int role) const
@@ -36,6 +67,39 @@ QVariant JsonTableModel::data(const QModelIndex &index, int role) const
     int rowIndex = index.row();
     int colIndex = index.column();
 
+    // cache column id of the cell
+    const bool isPath = isPathColumn(colIndex);
+    uint32_t columnId = 0;
+    if (isPath)
+        columnId = m_paths[colIndex - FIXED_COLUMNS].id;
+    else if (colIndex >= FIXED_COLUMNS)
+        columnId = static_cast<uint32_t>(colIndex - firstKeyColumn());
+
+    // check cache first, a hit does not need the parsed record
+    if (colIndex >= FIXED_COLUMNS) {
+        if (const QVariant* cached = m_cache.find(rowIndex, columnId))
+            return *cached;
+    }
+
+    // large records are parsed in background, the row is updated when done
+    if (!m_jsonFile->isParsed(rowIndex)) {
+        const size_t size = m_jsonFile->lineText(rowIndex).size();
+        if (size > ASYNC_PARSE_THRESHOLD) {
+            if (colIndex == 0)
+                return QString::number(rowIndex);
+            if (colIndex == 1)
+                return numberFormatter.toString(size);
+
+            // browsed in the tree through a structural index, never parsed as a whole
+            if (size > LAZY_DOCUMENT_BYTES)
+                return QVariant();
+
+            // only bookkeeping of the model changes, like the cache
+            const_cast<JsonTableModel*>(this)->parseInBackground(rowIndex);
+            return QString::fromUtf8("\u2026");
+        }
+    }
+
     const auto &line = m_jsonFile->line(rowIndex);
 
     if (line.keysUpdated) {
@@ -50,73 +114,94 @@ QVariant JsonTableModel::data(const QModelIndex &index, int role) const
         });
     }
 
-    if (colIndex-- == 0) {
+    if (colIndex == 0) {
         return QString::number(line.index);
     }
 
-    if (colIndex-- == 0) {
-        return locale.toString(line.size);
+    if (colIndex == 1) {
+        return numberFormatter.toString(line.size);
     }
 
-    if (line.doc.IsObject())
-    {
-        const auto &json = line.doc;
-        const std::string key = m_keys[colIndex].toStdString();
-        auto itr = json.FindMember(key.c_str());
-        if (itr != json.MemberEnd())
-        {
-            std::string cacheKey = key + ":" + std::to_string(line.index);
-            // check cache first
-            const auto it = m_cache.find(cacheKey);
-
-            if (it != m_cache.end())
-                return it->second;
-
-            // cache miss
-            const auto &val = itr->value;
-            QVariant result;
-            if (val.IsNull())
-                result = QString("null");
-            else if (val.IsString())
-                result = QString::fromUtf8(val.GetString());
-            else if (val.IsInt64())
-                result = locale.toString(val.GetInt64());
-            else if (val.IsUint64())
-                result = locale.toString(val.GetUint64());
-            else if (val.IsBool())
-                result = val.GetBool() ? "true" : "false";
-            else if (val.IsDouble())
-                result = locale.toString(val.GetDouble());
-            else {
-                result = QString::fromUtf8(toJsonString(val, MAX_JSON_STRING_LENGTH));
-            }
-
-            m_cache[cacheKey] = result;
-            return result;
-        }
+    // cache miss
+    const rapidjson::Value* val = nullptr;
+    if (isPath) {
+        val = m_paths[colIndex - FIXED_COLUMNS].path.extract(line.doc);
+    }
+    else if (line.shape) {
+        // the shape maps the column to the member slot directly
+        const int32_t slot = line.shape->slot(columnId);
+        if (slot >= 0)
+            val = &(line.doc.MemberBegin() + slot)->value;
     }
 
-    return QVariant();
+    // remember absent values as well
+    QVariant result = val ? formatValue(*val) : QVariant();
+    m_cache.insert(line.index, columnId, result);
+    return result;
 }
 
 QVariant JsonTableModel::headerData(int section, Qt::Orientation orientation, int role) const
 {
     if (role == Qt::DisplayRole && orientation == Qt::Horizontal) {
-        if (section -- == 0)
+        if (section == 0)
             return "#";
 
-        if (section -- == 0)
+        if (section == 1)
             return "Size";
 
-        return m_keys[section];
+        if (isPathColumn(section))
+            return m_paths[section - FIXED_COLUMNS].path.text();
+
+        return m_keys[section - firstKeyColumn()];
     }
     return QVariant();
 }
 
+bool JsonTableModel::addPathColumn(const QString& path, QString* error)
+{
+    auto compiled = JsonPath::compile(path, error);
+    if (!compiled)
+        return false;
+
+    int column = firstKeyColumn();
+    beginInsertColumns(QModelIndex(), column, column);
+    m_paths.push_back(PathColumn{std::move(*compiled), m_nextPathId++});
+    endInsertColumns();
+    return true;
+}
+
+bool JsonTableModel::isPathColumn(int column) const
+{
+    return column >= FIXED_COLUMNS && column < firstKeyColumn();
+}
+
+void JsonTableModel::removePathColumn(int column)
+{
+    if (!isPathColumn(column))
+        return;
+
+    // cached cells of the removed id are never looked up again and age out
+    beginRemoveColumns(QModelIndex(), column, column);
+    m_paths.erase(m_paths.begin() + (column - FIXED_COLUMNS));
+    endRemoveColumns();
+}
+
+std::optional<JsonPath> JsonTableModel::columnPath(int column) const
+{
+    if (isPathColumn(column))
+        return m_paths[column - FIXED_COLUMNS].path;
+
+    int key = column - firstKeyColumn();
+    if (column < FIXED_COLUMNS || key >= static_cast<int>(m_keys.size()))
+        return std::nullopt;
+
+    return JsonPath::member(m_keys[key]);
+}
+
 void JsonTableModel::doUpdateColumns() {
-    int knownCol = m_keys.size();
+    int knownCol = m_keys.size() + firstKeyColumn();
     m_keys = m_jsonFile->topLevelKeys();
-    int newCol = m_keys.size();
+    int newCol = m_keys.size() + firstKeyColumn();
 
     if (newCol > knownCol) {
         beginInsertColumns(QModelIndex(), knownCol, newCol - 1);
@@ -127,9 +212,50 @@ void JsonTableModel::doUpdateColumns() {
     }
 }
 
+void JsonTableModel::parseInBackground(int row)
+{
+    if (!m_parsing.insert(row).second)
+        return; // already queued
+
+    struct Parsed
+    {
+        rapidjson::Document doc;
+        std::vector<JsonSpan> spans;
+    };
+
+    const uint64_t generation = m_generation;
+    m_parsePool.start([this, row, generation]() {
+        auto parsed = std::make_shared<Parsed>();
+        m_jsonFile->parseLine(row, parsed->doc, parsed->spans);
+
+        QMetaObject::invokeMethod(this, [this, row, generation, parsed]() {
+            if (generation != m_generation)
+                return; // file was reloaded meanwhile
+
+            m_parsing.erase(row);
+            auto line = m_jsonFile->adoptLine(row, std::move(parsed->doc), std::move(parsed->spans));
+            if (line.keysUpdated)
+                doUpdateColumns();
+
+            Q_EMIT dataChanged(index(row, FIXED_COLUMNS), index(row, columnCount(QModelIndex()) - 1), {Qt::DisplayRole});
+        }, Qt::QueuedConnection);
+    });
+}
+
+void JsonTableModel::cancelParsing()
+{
+    // workers read the file mapping, they must be done before it goes away
+    ++m_generation;
+    m_parsePool.clear();
+    m_parsePool.waitForDone();
+    m_parsing.clear();
+}
+
 void JsonTableModel::reload() {
     beginResetModel();
     m_keys = m_jsonFile->topLevelKeys();
+    m_cache.clear(); // rows refer to the previous file contents
+    m_cache.resetCounters();
     // e.g., m_jsonFile->reload() if needed
     endResetModel();
 }
@@ -185,6 +311,10 @@ void JsonTableModel::searchCore(bool forward, const QString& query, QTableView*
 
     const auto searchString = query.toStdString();
 
+    auto& metrics = diagnostics::metrics();
+    metrics.searches.add();
+    diagnostics::ScopedTimer timer(metrics.searchNs);
+
     while (index.isValid()) {
         if (skipCurrent) {
             skipCurrent = false;
@@ -192,6 +322,7 @@ void JsonTableModel::searchCore(bool forward, const QString& query, QTableView*
 
             int row = index.row();
             const auto line = m_jsonFile->lineText(row);
+            metrics.searchedBytes.add(line.size());
 
             if (line.find(searchString) != std::string_view::npos) {
                 m_currentSearchIndex = index; // store the current search index
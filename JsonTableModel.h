@@ -1,6 +1,8 @@
 #pragma once
 
 #include "JsonFile.h"
+#include "CellCache.h"
+#include "JsonPath.h"
 
 #include <QAbstractTableModel>
 #include <QStringList>
@@ -9,6 +11,9 @@
 #include <QFuture>
 #include <QFutureWatcher>
 #include <QStatusBar>
+#include <QThreadPool>
+
+#include <unordered_set>
 
 class JsonTableModel : public QAbstractTableModel {
     Q_OBJECT
@@ -26,6 +31,19 @@ public:
     void reload();
     void search(bool forward, const QString& query, QTableView* tableView, QStatusBar *);
     void cancelSearch();
+    // stop background parsing of large records, before the file is closed
+    void cancelParsing();
+
+    const CellCache& cellCache() const { return m_cache; }
+    // the slots of the cache are fixed, only their values can be released
+    void trimCache(size_t target) { m_cache.trim(target); }
+
+    // columns showing a nested value, placed after the fixed ones
+    bool addPathColumn(const QString& path, QString* error = nullptr);
+    bool isPathColumn(int column) const;
+    void removePathColumn(int column);
+    // path extracting the values of a column, none for # and Size
+    std::optional<JsonPath> columnPath(int column) const;
 
 signals:
     void updateColumns() const;
@@ -34,16 +52,38 @@ public slots:
     void doUpdateColumns();
 
 private:
+    struct PathColumn
+    {
+        JsonPath path;
+        uint32_t id; // cache column id, stable while the column exists
+    };
+
+    // path columns use cache ids that can't collide with top level keys
+    static constexpr uint32_t PATH_COLUMN_BASE = 0x80000000u;
+    static constexpr int FIXED_COLUMNS = 2;
+
     JsonFile* m_jsonFile;
     std::vector<QString> m_keys;
+    std::vector<PathColumn> m_paths;
+    uint32_t m_nextPathId = PATH_COLUMN_BASE;
     std::optional<QString> m_query;
     std::optional<QModelIndex> m_currentSearchIndex;
 
-    mutable std::map<std::string, QVariant> m_cache;
+    mutable CellCache m_cache;
 
     QFuture<void> searchFuture;
     QFutureWatcher<void> searchWatcher;
 
+    // rows being parsed in background
+    std::unordered_set<int> m_parsing;
+    uint64_t m_generation = 0;
+    QThreadPool m_parsePool; // last, so workers are done before the rest is destroyed
+
+    void parseInBackground(int row);
+
     void searchCore(bool forward, const QString& query, QTableView* tableView, QStatusBar *);
 
+    int firstKeyColumn() const { return FIXED_COLUMNS + static_cast<int>(m_paths.size()); }
+    static QVariant formatValue(const rapidjson::Value& val);
+
 };
@@ -2,74 +2,231 @@
 
 #include "constants.h"
 
-JsonTreeItem::JsonTreeItem(const rapidjson::Value* value, QString key)
-    : JsonTreeItem(value, std::move(key), nullptr, 0, false)
+#include <algorithm>
+#include <cstring>
+#include <new>
+
+namespace
+{
+    // value of lazy containers, gives them the right type without any members
+    const rapidjson::Value* placeholder(bool object)
+    {
+        static const rapidjson::Value emptyObject(rapidjson::kObjectType);
+        static const rapidjson::Value emptyArray(rapidjson::kArrayType);
+        return object ? &emptyObject : &emptyArray;
+    }
+
+    // children per range, nesting ranges when there are too many for one level
+    size_t rangeGroup(size_t count, size_t bucketSize)
+    {
+        size_t group = bucketSize;
+        while ((count + group - 1) / group > bucketSize)
+            group *= bucketSize;
+        return group;
+    }
+}
+
+JsonTreeItem* JsonTreeItem::createRoot(JsonTreeStorage* storage, const rapidjson::Value* value)
+{
+    return new (storage->allocate(1)) JsonTreeItem(storage, value, nullptr, Kind::Root, nullptr, 0, 0, 0);
+}
+
+JsonTreeItem* JsonTreeItem::createLazyRoot(JsonTreeStorage* storage)
 {
+    const StructuralIndex* structure = storage->structure();
+    auto* root = new (storage->allocate(1)) JsonTreeItem(storage, placeholder(structure->isObject(0)), nullptr, Kind::Root, nullptr, 0, 0, structure->node(0).offset);
+    root->m_node = 0;
+    return root;
 }
 
 JsonTreeItem::JsonTreeItem(
+    JsonTreeStorage* storage,
     const rapidjson::Value* value,
-    QString key,
+    const rapidjson::Value* name,
+    Kind kind,
     JsonTreeItem* parent,
     size_t index,
-    bool lineExtension
+    size_t position,
+    size_t spanIndex
 )
-: m_value(value)
-, m_key(std::move(key))
+: m_storage(storage)
+, m_value(value)
+, m_name(name)
 , m_parent(parent)
-, m_index(index)
-, m_lineExtension(lineExtension)
+, m_children(nullptr)
+, m_spanIndex(spanIndex)
+, m_index(static_cast<uint32_t>(index))
+, m_position(static_cast<uint32_t>(position))
+, m_size(0)
+, m_childCount(0)
+, m_node(StructuralIndex::NO_NODE)
+, m_lineCount(1)
+, m_kind(kind)
+, m_childrenKnown(false)
 {
     if (value && value->IsString()) {
+        // the view never shows more lines, so stop counting there
         const char* str = value->GetString();
-        size_t len = value->GetStringLength();
-        m_isMultiline = !!memchr(str, '\n', len);
-        // printf("isMultiline: %d, %s\n", m_isMultiline, key.toUtf8().constData());
-    }
-    else {
-        m_isMultiline = false;
+        const char* end = str + value->GetStringLength();
+        while (m_lineCount < MAX_CELL_LINES) {
+            str = static_cast<const char*>(memchr(str, '\n', end - str));
+            if (!str)
+                break;
+            ++str;
+            ++m_lineCount;
+        }
     }
-
-    m_byteSize = toJsonString(*m_value).size();
 }
 
-JsonTreeItem::~JsonTreeItem()
+size_t JsonTreeItem::containerSize() const
 {
-    qDeleteAll(m_children);
+    if (isLazy())
+        return m_storage->structure()->node(m_node).children;
+    if (m_value->IsObject())
+        return m_value->MemberCount();
+    if (m_value->IsArray())
+        return m_value->Size();
+    return 0;
 }
 
 void JsonTreeItem::ensureChildren()
 {
-    if (!m_children.empty()) // children already known
+    if (m_childrenKnown) // children already known
         return;
 
+    m_childrenKnown = true;
+    if (!m_value)
+        return;
+
+    if (m_kind == Kind::Range) {
+        populate(m_position, m_size, m_spanIndex);
+    } else if (m_value->IsObject() || m_value->IsArray()) {
+        // children spans follow the parent one
+        populate(0, containerSize(), m_spanIndex + 1);
+    } else if (m_value->IsString() && m_kind != Kind::LineExtension && m_lineCount > 1) {
+        m_childCount = 1;
+        m_children = new (m_storage->allocate(1)) JsonTreeItem(m_storage, m_value, nullptr, Kind::LineExtension, this, 0, 0, m_spanIndex);
+        m_children->m_size = m_size;
+    }
+}
+
+void JsonTreeItem::populate(size_t first, size_t count, size_t spanIndex)
+{
+    if (isLazy()) {
+        populateLazy(first, count, spanIndex);
+        return;
+    }
+
+    // each subtree is skipped as a whole
+    const JsonSource* source = m_storage->source();
+    const bool hasSpans = source->valid();
+    auto skipSpans = [&](size_t items) {
+        if (hasSpans) {
+            while (items--)
+                spanIndex += source->span(spanIndex).descendants + 1;
+        }
+    };
+
+    const size_t bucketSize = m_storage->bucketSize();
+    if (bucketSize > 1 && count > bucketSize) {
+        // split into ranges, nesting them when there are too many ranges for one level
+        const size_t group = rangeGroup(count, bucketSize);
+        m_childCount = static_cast<uint32_t>((count + group - 1) / group);
+        m_children = m_storage->allocate(m_childCount);
+        for (size_t i = 0; i < m_childCount; ++i) {
+            size_t rangeFirst = first + i * group;
+            size_t rangeSize = std::min(group, count - i * group);
+            auto* range = new (&m_children[i]) JsonTreeItem(m_storage, m_value, nullptr, Kind::Range, this, i, rangeFirst, spanIndex);
+            range->m_size = static_cast<uint32_t>(rangeSize);
+            skipSpans(rangeSize);
+        }
+        return;
+    }
+
+    m_childCount = static_cast<uint32_t>(count);
+    m_children = m_storage->allocate(m_childCount);
+
     if (m_value->IsObject()) {
-        size_t index = 0;
-        for (auto it = m_value->MemberBegin(); it != m_value->MemberEnd(); ++it) {
-            QString key = QString::fromUtf8(it->name.GetString(), it->name.GetStringLength());
-            m_children.push_back(new JsonTreeItem(&it->value, key, this, index++, false));
+        auto it = m_value->MemberBegin() + first;
+        for (size_t i = 0; i < count; ++i, ++it) {
+            new (&m_children[i]) JsonTreeItem(m_storage, &it->value, &it->name, Kind::Member, this, i, first + i, spanIndex);
+            skipSpans(1);
         }
-    } else if (m_value->IsArray()) {
-        size_t index = 0;
-        m_children.reserve(m_value->Size());
-        for (rapidjson::SizeType i = 0; i < m_value->Size(); ++i) {
-            m_children.push_back(new JsonTreeItem(&(*m_value)[i], QString("[%1]").arg(i), this, index++, false));
+    } else {
+        for (size_t i = 0; i < count; ++i) {
+            auto position = static_cast<rapidjson::SizeType>(first + i);
+            new (&m_children[i]) JsonTreeItem(m_storage, &(*m_value)[position], nullptr, Kind::Element, this, i, position, spanIndex);
+            skipSpans(1);
         }
-    } else if (m_value->IsString() && !m_lineExtension && m_isMultiline) {
-        m_children.push_back(new JsonTreeItem(m_value, QString("..."), this, 0, true));
     }
 }
 
+void JsonTreeItem::populateLazy(size_t first, size_t count, size_t offset)
+{
+    // only the bytes of this container are tokenized, large children are jumped over
+    const StructuralIndex* structure = m_storage->structure();
+    const size_t bucketSize = m_storage->bucketSize();
+    size_t i = 0;
+
+    if (bucketSize > 1 && count > bucketSize) {
+        // a range starts at the offset of its first child
+        const size_t group = rangeGroup(count, bucketSize);
+        m_children = m_storage->allocate((count + group - 1) / group);
+        structure->forEachChild(m_node, offset, [&](const StructuralIndex::Child& child) {
+            if (i % group == 0) {
+                const size_t index = i / group;
+                auto* range = new (&m_children[index]) JsonTreeItem(m_storage, m_value, nullptr, Kind::Range, this, index, first + i, child.offset);
+                range->m_size = static_cast<uint32_t>(std::min(group, count - i));
+                range->m_node = m_node;
+            }
+            return ++i < count;
+        });
+        m_childCount = static_cast<uint32_t>((i + group - 1) / group);
+        return;
+    }
+
+    // small children are parsed, the storage keeps them until the model is reset
+    const bool object = m_value->IsObject();
+    m_children = m_storage->allocate(count);
+    structure->forEachChild(m_node, offset, [&](const StructuralIndex::Child& child) {
+        const rapidjson::Value* name = object ? m_storage->parse(child.key) : nullptr;
+        const bool indexed = child.node != StructuralIndex::NO_NODE;
+        const rapidjson::Value* value = indexed ? placeholder(structure->isObject(child.node)) : m_storage->parse(child.value);
+        if (!value || (object && !name))
+            return false;
+
+        const size_t valueOffset = child.value.data() - structure->text().data();
+        auto* item = new (&m_children[i]) JsonTreeItem(m_storage, value, name, object ? Kind::Member : Kind::Element, this, i, first + i, valueOffset);
+        item->m_node = child.node;
+        // parsed values are below 4 GB, rapidjson can't hold longer strings
+        item->m_size = static_cast<uint32_t>(child.value.size());
+        return ++i < count;
+    });
+    m_childCount = static_cast<uint32_t>(i);
+}
+
+QString JsonTreeItem::key() const
+{
+    switch (m_kind) {
+        case Kind::Root: return QStringLiteral("root");
+        case Kind::Member: return m_storage->key(*m_name);
+        case Kind::Element: return QStringLiteral("[%1]").arg(m_position);
+        case Kind::LineExtension: return QStringLiteral("...");
+        case Kind::Range: return QStringLiteral("[%1 \u2026 %2]").arg(m_position).arg(m_position + m_size - 1);
+    }
+    return {};
+}
+
 JsonTreeItem* JsonTreeItem::child(int row)
 {
     ensureChildren();
-    return (row >= 0 && row < m_children.size()) ? m_children[row] : nullptr;
+    return (row >= 0 && row < static_cast<int>(m_childCount)) ? &m_children[row] : nullptr;
 }
 
 int JsonTreeItem::childCount()
 {
     ensureChildren();
-    return static_cast<int>(m_children.size());
+    return static_cast<int>(m_childCount);
 }
 
 int JsonTreeItem::row() const
@@ -82,38 +239,55 @@ QVariant JsonTreeItem::data(int column) const
 {
 
     if (column == TreeViewColumn::KeyColumn)
-        return m_key;
+        return key();
 
     if (!m_value)
         return QVariant();
 
+    if (m_kind == Kind::Range) {
+        // synthetic group of children, nothing to show besides the count
+        if (column == TreeViewColumn::SizeColumn)
+            return numberFormatter.toString(m_size);
+        return QVariant();
+    }
+
     if (column == TreeViewColumn::SizeColumn) {
+        if (isLazy())
+            return numberFormatter.toString(containerSize());
         if (m_value->IsObject())
-            return locale.toString(m_value->MemberCount());
+            return numberFormatter.toString(m_value->MemberCount());
         if (m_value->IsArray())
-            return locale.toString(m_value->Size());
+            return numberFormatter.toString(m_value->Size());
 
         return 0;
     }
 
     if (column == TreeViewColumn::BytesColumn) {
-        return locale.toString(qint64(m_byteSize));
+        return numberFormatter.toString(byteSize());
         // return m_value ? m_value->GetStringLength() : 0;
     }
 
     if (column == TreeViewColumn::ValueColumn) {
+        if (isLazy())
+            return QString::fromUtf8(toJsonString(rawSource(), MAX_JSON_STRING_LENGTH));
         if (m_value->IsString()) {
-            if (!m_isMultiline || m_lineExtension) // return as is
-                return QString::fromUtf8(m_value->GetString());
+            const char* str = m_value->GetString();
+            size_t length = m_value->GetStringLength();
 
-            QString str = QString::fromUtf8(m_value->GetString(), m_value->GetStringLength());
-            return str.first(str.indexOf('\n')) + "..."; // cut off the first line
+            if (m_lineCount > 1 && m_kind != Kind::LineExtension) {
+                // cut off the first line
+                length = static_cast<const char*>(memchr(str, '\n', length)) - str;
+                return preview(str, length) + "...";
+            }
+
+            // return as is, large strings are read through StringBytesRole
+            return preview(str, length);
         }
         if (m_value->IsNull()) return "null";
         if (m_value->IsBool()) return m_value->GetBool() ? "true" : "false";
-        if (m_value->IsInt64()) return locale.toString(m_value->GetInt64()); // qint64(m_value->GetInt64());
-        if (m_value->IsUint64()) return locale.toString(m_value->GetUint64()); // qint64(m_value->GetInt64());
-        if (m_value->IsDouble()) return locale.toString(m_value->GetDouble()); // m_value->GetDouble();
+        if (m_value->IsInt64()) return numberFormatter.toString(m_value->GetInt64()); // qint64(m_value->GetInt64());
+        if (m_value->IsUint64()) return numberFormatter.toString(m_value->GetUint64()); // qint64(m_value->GetInt64());
+        if (m_value->IsDouble()) return numberFormatter.toString(m_value->GetDouble()); // m_value->GetDouble();
         if (m_value->IsArray()) return QString::fromUtf8(toJsonString(*m_value, MAX_JSON_STRING_LENGTH));
         if (m_value->IsObject()) return QString::fromUtf8(toJsonString(*m_value, MAX_JSON_STRING_LENGTH));
     }
@@ -121,20 +295,88 @@ QVariant JsonTreeItem::data(int column) const
     return {};
 }
 
+QString JsonTreeItem::preview(const char* str, size_t length)
+{
+    if (length <= LARGE_STRING_LENGTH)
+        return QString::fromUtf8(str, length);
+
+    size_t limit = LARGE_STRING_PREVIEW;
+    // don't split a utf-8 sequence
+    while (limit > 0 && (static_cast<unsigned char>(str[limit]) & 0xC0) == 0x80)
+        --limit;
+    return QString::fromUtf8(str, limit) + QStringLiteral("\u2026");
+}
+
+QByteArray JsonTreeItem::stringBytes() const
+{
+    if (m_kind == Kind::Range || !m_value || !m_value->IsString())
+        return QByteArray();
+
+    // refers to the document, valid while the model lives
+    return QByteArray::fromRawData(m_value->GetString(), m_value->GetStringLength());
+}
+
 QString JsonTreeItem::getText(bool pretty) const
 {
+    if (m_kind == Kind::Range) return QString();
+    if (isLazy()) return getRawText();
     if (m_value->IsString()) return QString::fromUtf8(m_value->GetString());
     if (m_value->IsNull()) return "null";
     if (m_value->IsBool()) return m_value->GetBool() ? "true" : "false";
-    if (m_value->IsInt64()) return pretty ? locale.toString(m_value->GetInt64()) : QString::number(m_value->GetInt64()); // qint64(m_value->GetInt64());
-    if (m_value->IsUint64()) return pretty ? locale.toString(m_value->GetUint64()) : QString::number(m_value->GetUint64()); // qint64(m_value->GetInt64());
-    if (m_value->IsDouble()) return pretty ? locale.toString(m_value->GetDouble()) : QString::number(m_value->GetDouble()); // m_value->GetDouble();
+    if (m_value->IsInt64()) return pretty ? numberFormatter.toString(m_value->GetInt64()) : QString::number(m_value->GetInt64()); // qint64(m_value->GetInt64());
+    if (m_value->IsUint64()) return pretty ? numberFormatter.toString(m_value->GetUint64()) : QString::number(m_value->GetUint64()); // qint64(m_value->GetInt64());
+    if (m_value->IsDouble()) return pretty ? numberFormatter.toString(m_value->GetDouble()) : QString::number(m_value->GetDouble()); // m_value->GetDouble();
     if (m_value->IsArray()) return QString::fromUtf8(pretty ? toJsonStringPretty(*m_value) : toJsonString(*m_value));
     if (m_value->IsObject()) return QString::fromUtf8(pretty ? toJsonStringPretty(*m_value) : toJsonString(*m_value));
 
     return QString(); // Return empty string for unsupported types
 }
 
+std::string_view JsonTreeItem::rawSource() const
+{
+    if (m_kind == Kind::Range)
+        return std::string_view();
+
+    // items listed from the structure of a lazy model know the byte offset of their value,
+    // descendants of the values parsed there don't and are serialized instead
+    if (const StructuralIndex* structure = m_storage->structure()) {
+        if (isLazy())
+            return structure->source(m_node);
+        return m_size ? structure->text().substr(m_spanIndex, m_size) : std::string_view();
+    }
+
+    const JsonSource* source = m_storage->source();
+    if (!source->valid())
+        return std::string_view();
+
+    return source->slice(m_spanIndex);
+}
+
+QString JsonTreeItem::getRawText() const
+{
+    if (m_kind == Kind::Range)
+        return QString();
+
+    auto raw = rawSource();
+    if (!raw.empty())
+        return QString::fromUtf8(raw.data(), raw.size());
+
+    return getText(false);
+}
+
+size_t JsonTreeItem::byteSize() const
+{
+    if (m_storage->structure() && (isLazy() || m_size))
+        return rawSource().size();
+
+    const JsonSource* source = m_storage->source();
+    if (source->valid())
+        return source->span(m_spanIndex).length;
+
+    // no source available, measure serialized value
+    return m_value ? toJsonString(*m_value).size() : 0;
+}
+
 JsonTreeItem* JsonTreeItem::parent() const
 {
     return m_parent;
@@ -142,7 +384,10 @@ JsonTreeItem* JsonTreeItem::parent() const
 
 bool JsonTreeItem::match(const QString& query) const
 {
-    if (m_key.contains(query, Qt::CaseInsensitive))
+    if (m_kind == Kind::Range)
+        return false;
+
+    if (key().contains(query, Qt::CaseInsensitive))
         return true;
 
     if (m_value->IsString()) {
@@ -155,19 +400,19 @@ bool JsonTreeItem::match(const QString& query) const
     }
 
     if (m_value->IsInt64()) {
-        return locale.toString(m_value->GetInt64()).contains(query, Qt::CaseInsensitive)
+        return numberFormatter.toString(m_value->GetInt64()).contains(query, Qt::CaseInsensitive)
             || QString::number(m_value->GetInt64()).contains(query, Qt::CaseInsensitive)
             ;
     }
 
     if (m_value->IsUint64()) {
-        return locale.toString(m_value->GetUint64()).contains(query, Qt::CaseInsensitive)
+        return numberFormatter.toString(m_value->GetUint64()).contains(query, Qt::CaseInsensitive)
             || QString::number(m_value->GetUint64()).contains(query, Qt::CaseInsensitive)
             ;
     }
 
     if (m_value->IsDouble()) {
-        return locale.toString(m_value->GetDouble()).contains(query, Qt::CaseInsensitive)
+        return numberFormatter.toString(m_value->GetDouble()).contains(query, Qt::CaseInsensitive)
             || QString::number(m_value->GetDouble()).contains(query, Qt::CaseInsensitive);
             ;
     }
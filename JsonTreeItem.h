@@ -3,6 +3,7 @@
 #include "constants.h"
 #include "json.h"
 #include "Locale.h"
+#include "JsonTreeStorage.h"
 
 #include <rapidjson/document.h>
 
@@ -10,13 +11,28 @@
 #include <QLocale>
 #include <QVariant>
 #include <QString>
-#include <vector>
+#include <QByteArray>
+#include <cstdint>
+#include <string_view>
 
+// Items are allocated from JsonTreeStorage and are never deleted individually,
+// keep them trivially destructible.
 class JsonTreeItem {
 public:
-    JsonTreeItem(const rapidjson::Value* value, QString key);
-    JsonTreeItem(const rapidjson::Value* value, QString key, JsonTreeItem* parent, size_t index, bool lineExtension);
-    ~JsonTreeItem();
+    enum class Kind : uint8_t
+    {
+        Root,
+        Member,         // object member, key is the member name
+        Element,        // array element, key is the index
+        LineExtension,  // continuation of a multiline string
+        Range,          // synthetic group of children of a large container
+    };
+
+    static JsonTreeItem* createRoot(JsonTreeStorage* storage, const rapidjson::Value* value);
+    // root of the document indexed by the structure of the storage
+    static JsonTreeItem* createLazyRoot(JsonTreeStorage* storage);
+
+    JsonTreeItem(JsonTreeStorage* storage, const rapidjson::Value* value, const rapidjson::Value* name, Kind kind, JsonTreeItem* parent, size_t index, size_t position, size_t spanIndex);
 
     void ensureChildren();
 
@@ -26,23 +42,55 @@ public:
     int row() const;
 
     QVariant data(int column) const;
+    QString key() const;
 
-    bool isMultiline() const { return m_isMultiline && m_lineExtension; }
+    bool isMultiline() const { return m_lineCount > 1 && m_kind == Kind::LineExtension; }
+    // a string too large to be copied for display, the item showing all of it
+    bool hasLargeText() const
+    {
+        return m_value && m_value->IsString() && m_value->GetStringLength() > LARGE_STRING_LENGTH
+            && (m_kind == Kind::LineExtension || m_lineCount == 1);
+    }
+    // lines shown in the value column, capped at MAX_CELL_LINES
+    int lineCount() const { return hasLargeText() ? MAX_CELL_LINES : isMultiline() ? m_lineCount : 1; }
+    // bytes of a string value without a copy
+    QByteArray stringBytes() const;
 
     static JsonTreeItem * fromIndex(const QModelIndex& index) {
         return static_cast<JsonTreeItem*>(index.internalPointer());
     }
 
+    // a large container of a StructuralIndex, children are found when expanded
+    bool isLazy() const { return m_node != StructuralIndex::NO_NODE; }
+    // the value of the item, none for ranges and lazy containers
+    const rapidjson::Value* value() const { return m_kind == Kind::Range || isLazy() ? nullptr : m_value; }
+    // text of the value in the record, empty when spans are not available
+    std::string_view rawSource() const;
+
     bool match(const QString& query) const;
     QString getText(bool pretty) const;
+    QString getRawText() const;
+    size_t byteSize() const;
 
 private:
+    // the string, or its beginning when it is large
+    static QString preview(const char* str, size_t length);
+    size_t containerSize() const;
+    void populate(size_t first, size_t count, size_t spanIndex);
+    void populateLazy(size_t first, size_t count, size_t offset);
+
+    JsonTreeStorage* m_storage;
     const rapidjson::Value* m_value;
-    QString m_key;
+    const rapidjson::Value* m_name;
     JsonTreeItem* m_parent;
-    size_t m_index;
-    bool m_isMultiline;
-    bool m_lineExtension;
-    std::vector<JsonTreeItem*> m_children;
-    size_t m_byteSize;
+    JsonTreeItem* m_children;
+    size_t m_spanIndex;       // span of the value, or of the first child for ranges; a byte offset in lazy models
+    uint32_t m_index;         // row in the parent
+    uint32_t m_position;      // index in the container, or the first child for ranges
+    uint32_t m_size;          // children of a range, or bytes of a value listed by populateLazy, 0 below it
+    uint32_t m_childCount;
+    uint32_t m_node;          // of the structure, or of the parent for ranges
+    uint16_t m_lineCount;     // lines of a string value, counted once up to MAX_CELL_LINES
+    Kind m_kind;
+    bool m_childrenKnown;
 };
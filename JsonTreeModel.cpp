@@ -1,23 +1,57 @@
 #include "JsonTreeModel.h"
+#include "Diagnostics.h"
 
 #include <QTreeView>
 
-JsonTreeModel::JsonTreeModel(const rapidjson::Value* rootValue, QObject* parent)
-    : QAbstractItemModel(parent), m_root(new JsonTreeItem(rootValue, "root"))
+JsonTreeModel::JsonTreeModel(const rapidjson::Value* rootValue, JsonSource source, size_t bucketSize, QObject* parent)
+    : QAbstractItemModel(parent), m_storage(source), m_root(JsonTreeItem::createRoot(&m_storage, rootValue))
 {
+    m_storage.setBucketSize(bucketSize);
+    diagnostics::metrics().treeModels.add();
+}
 
+JsonTreeModel::JsonTreeModel(std::unique_ptr<rapidjson::Document> document, std::vector<JsonSpan> spans, std::string_view text, size_t bucketSize, QObject* parent)
+    : QAbstractItemModel(parent)
+    , m_document(std::move(document))
+    , m_spans(std::move(spans))
+    , m_storage(JsonSource{text, &m_spans})
+    , m_root(JsonTreeItem::createRoot(&m_storage, m_document.get()))
+{
+    m_storage.setBucketSize(bucketSize);
+    diagnostics::metrics().treeModels.add();
+}
+
+JsonTreeModel::JsonTreeModel(std::unique_ptr<StructuralIndex> structure, size_t bucketSize, QObject* parent)
+    : QAbstractItemModel(parent)
+    , m_structure(std::move(structure))
+{
+    m_storage.setBucketSize(bucketSize);
+    m_storage.setStructure(m_structure.get());
+    m_root = JsonTreeItem::createLazyRoot(&m_storage);
+    diagnostics::metrics().treeModels.add();
 }
 
 JsonTreeModel::~JsonTreeModel()
 {
-    delete m_root;
+}
+
+size_t JsonTreeModel::memoryUsage() const
+{
+    size_t bytes = m_storage.memoryUsage() + m_spans.capacity() * sizeof(JsonSpan);
+    if (m_document)
+        bytes += m_document->GetAllocator().Capacity();
+    if (m_structure)
+        bytes += m_structure->memoryUsage();
+    return bytes;
 }
 
 void JsonTreeModel::reload()
 {
     beginResetModel();
-    delete m_root;
-    m_root = new JsonTreeItem(nullptr, "root");
+    m_storage.clear();
+    m_storage.setSource(JsonSource{});
+    m_storage.setStructure(nullptr);
+    m_root = JsonTreeItem::createRoot(&m_storage, nullptr);
     endResetModel();
 }
 
@@ -61,6 +95,15 @@ QVariant JsonTreeModel::data(const QModelIndex& index, int role) const
         return static_cast<int>(Qt::AlignTop | Qt::AlignLeft);
     }
 
+    if (role == LineCountRole) {
+        return JsonTreeItem::fromIndex(index)->lineCount();
+    }
+
+    if (role == StringBytesRole) {
+        auto* item = JsonTreeItem::fromIndex(index);
+        return item->hasLargeText() ? QVariant(item->stringBytes()) : QVariant();
+    }
+
     return {};
 }
 
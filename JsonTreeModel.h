@@ -6,11 +6,23 @@
 
 #include "JsonTreeItem.h"
 
+#include <memory>
+
 class JsonTreeModel : public QAbstractItemModel {
     Q_OBJECT
 
 public:
-    JsonTreeModel(const rapidjson::Value* rootValue, QObject* parent = nullptr);
+    enum Role
+    {
+        LineCountRole = Qt::UserRole + 1, // lines of the value, counted when the item is created
+        StringBytesRole,                  // QByteArray over the bytes of a large string, not copied
+    };
+
+    JsonTreeModel(const rapidjson::Value* rootValue, JsonSource source, size_t bucketSize = TREE_BUCKET_SIZE, QObject* parent = nullptr);
+    // owns a record parsed outside of JsonFile, e.g. on a worker thread
+    JsonTreeModel(std::unique_ptr<rapidjson::Document> document, std::vector<JsonSpan> spans, std::string_view text, size_t bucketSize = TREE_BUCKET_SIZE, QObject* parent = nullptr);
+    // browses a record too large for a DOM, containers are tokenized when expanded
+    explicit JsonTreeModel(std::unique_ptr<StructuralIndex> structure, size_t bucketSize = TREE_BUCKET_SIZE, QObject* parent = nullptr);
     ~JsonTreeModel() override;
 
     QModelIndex index(int row, int column, const QModelIndex& parent) const override;
@@ -25,10 +37,20 @@ public:
     Qt::ItemFlags flags(const QModelIndex& index) const;
 
     void reload();
+    // items plus the owned record, if any
+    size_t memoryUsage() const;
+    // browsed through a StructuralIndex, values live only as long as the model
+    bool isLazy() const { return m_structure != nullptr; }
+    // the owned record, shared with work that may outlive the model
+    std::shared_ptr<const rapidjson::Document> document() const { return m_document; }
     void search(bool forward, const QString& query, QTreeView* tableView, QStatusBar*);
     void cancelSearch();
 
 private:
+    std::shared_ptr<rapidjson::Document> m_document;
+    std::vector<JsonSpan> m_spans;
+    std::unique_ptr<StructuralIndex> m_structure;
+    JsonTreeStorage m_storage;
     JsonTreeItem* m_root;
     std::optional<QModelIndex> m_currentSearchIndex;
 
@@ -0,0 +1,69 @@
+#include "JsonTreeStorage.h"
+#include "JsonTreeItem.h"
+#include "Diagnostics.h"
+
+#include <algorithm>
+#include <new>
+#include <type_traits>
+
+// items are never destroyed one by one, dropping the blocks releases them
+static_assert(std::is_trivially_destructible_v<JsonTreeItem>);
+
+JsonTreeStorage::JsonTreeStorage(JsonSource source)
+    : m_source(source)
+{
+}
+
+JsonTreeStorage::~JsonTreeStorage() = default;
+
+JsonTreeItem* JsonTreeStorage::allocate(size_t count)
+{
+    if (count > m_available) {
+        // large sibling lists get a block of their own
+        size_t items = std::max(count, BLOCK_ITEMS);
+        m_blocks.emplace_back(new std::byte[items * sizeof(JsonTreeItem)]);
+        m_blockBytes += items * sizeof(JsonTreeItem);
+        m_current = m_blocks.back().get();
+        m_available = items;
+    }
+
+    auto* result = reinterpret_cast<JsonTreeItem*>(m_current);
+    m_current += count * sizeof(JsonTreeItem);
+    m_available -= count;
+    m_itemCount += count;
+    diagnostics::metrics().treeItems.add(count);
+    return result;
+}
+
+void JsonTreeStorage::clear()
+{
+    m_blocks.clear();
+    m_current = nullptr;
+    m_available = 0;
+    m_itemCount = 0;
+    m_blockBytes = 0;
+    m_keys.clear();
+    m_values.Clear();
+}
+
+const rapidjson::Value* JsonTreeStorage::parse(std::string_view text)
+{
+    rapidjson::Document doc(&m_values);
+    if (doc.Parse(text.data(), text.size()).HasParseError())
+        return nullptr;
+
+    // the document only borrows the allocator, its value moves there as well
+    auto* value = new (m_values.Malloc(sizeof(rapidjson::Value))) rapidjson::Value();
+    value->Swap(doc);
+    return value;
+}
+
+const QString& JsonTreeStorage::key(const rapidjson::Value& name)
+{
+    std::string_view view(name.GetString(), name.GetStringLength());
+    auto it = m_keys.find(view);
+    if (it == m_keys.end())
+        it = m_keys.emplace(view, QString::fromUtf8(view.data(), view.size())).first;
+
+    return it->second;
+}
@@ -0,0 +1,67 @@
+#pragma once
+
+#include "constants.h"
+#include "json.h"
+#include "StructuralIndex.h"
+
+#include <rapidjson/document.h>
+
+#include <QString>
+
+#include <memory>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+class JsonTreeItem;
+
+// per-model storage of tree items: items are carved out of large blocks,
+// siblings are allocated contiguously and the whole tree is released at once
+class JsonTreeStorage
+{
+public:
+    explicit JsonTreeStorage(JsonSource source = {});
+    ~JsonTreeStorage();
+
+    JsonTreeStorage(const JsonTreeStorage&) = delete;
+    JsonTreeStorage& operator=(const JsonTreeStorage&) = delete;
+
+    // returns uninitialized room for `count` adjacent items, construct them with placement new
+    JsonTreeItem* allocate(size_t count);
+    void clear();
+
+    const JsonSource* source() const { return &m_source; }
+    void setSource(JsonSource source) { m_source = source; }
+
+    // index of a record browsed without a DOM, see JsonTreeItem::isLazy
+    const StructuralIndex* structure() const { return m_structure; }
+    void setStructure(const StructuralIndex* structure) { m_structure = structure; }
+    // parses a value of the structure, it lives as long as the items; null on errors
+    const rapidjson::Value* parse(std::string_view text);
+
+    // keys are shared by all items with the same member name
+    const QString& key(const rapidjson::Value& name);
+
+    size_t itemCount() const { return m_itemCount; }
+    // bytes of item blocks and parsed values, items own no further memory besides shared keys
+    size_t memoryUsage() const { return m_blockBytes + m_values.Capacity(); }
+
+    // containers with more children than this are presented as nested ranges, 0 disables grouping
+    size_t bucketSize() const { return m_bucketSize; }
+    void setBucketSize(size_t bucketSize) { m_bucketSize = bucketSize; }
+
+private:
+    static constexpr size_t BLOCK_ITEMS = 4096;
+
+    JsonSource m_source;
+    const StructuralIndex* m_structure = nullptr;
+    rapidjson::MemoryPoolAllocator<> m_values;
+    size_t m_bucketSize = TREE_BUCKET_SIZE;
+    std::vector<std::unique_ptr<std::byte[]>> m_blocks;
+    std::byte* m_current = nullptr;
+    size_t m_available = 0;
+    size_t m_itemCount = 0;
+    size_t m_blockBytes = 0;
+
+    std::unordered_map<std::string_view, QString> m_keys;
+};
@@ -0,0 +1,363 @@
+// Benchmarks of the non-GUI core on synthetic datasets, results are written as JSON
+// so runs on different commits can be compared.
+//
+//   JsonViewBench [--scale 0.1] [--repeat 5] [--filter name] [--label commit] [--output results.json]
+
+#include "json.h"
+#include "jsonParser.h"
+#include "JsonFile.h"
+#include "JsonTreeItem.h"
+#include "JsonTreeStorage.h"
+#include "Locale.h"
+#include "SyntheticData.h"
+#include "constants.h"
+
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QTemporaryFile>
+
+#include <rapidjson/prettywriter.h>
+#include <rapidjson/stringbuffer.h>
+
+#include <sys/resource.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace
+{
+    using Clock = std::chrono::steady_clock;
+
+    uint64_t nanoseconds(Clock::duration duration)
+    {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(duration).count();
+    }
+
+    size_t peakRssKb()
+    {
+        rusage usage{};
+        getrusage(RUSAGE_SELF, &usage);
+        return static_cast<size_t>(usage.ru_maxrss); // kilobytes on Linux
+    }
+
+    struct Result
+    {
+        std::string name;
+        std::string dataset;
+        size_t bytes = 0;             // processed in all passes
+        size_t items = 0;             // records, values or calls in all passes
+        uint64_t totalNs = 0;
+        std::vector<uint64_t> samples; // latency of one operation, ns
+        size_t peakRss = 0;
+    };
+
+    uint64_t percentile(std::vector<uint64_t>& sorted, double p)
+    {
+        if (sorted.empty())
+            return 0;
+        size_t index = static_cast<size_t>(p * (sorted.size() - 1) + 0.5);
+        return sorted[std::min(index, sorted.size() - 1)];
+    }
+
+    // keeps results alive so the optimizer can't drop the measured work
+    volatile size_t sink = 0;
+
+    class Bench
+    {
+    public:
+        Bench(int repeat, std::string filter) : m_repeat(repeat), m_filter(std::move(filter)) {}
+
+        bool enabled(const std::string& name) const
+        {
+            return m_filter.empty() || name.find(m_filter) != std::string::npos;
+        }
+
+        // runs `pass` `repeat` times, a pass returns the latencies of its operations
+        void run(const std::string& name, const synthetic::Dataset& dataset, size_t bytesPerPass, size_t itemsPerPass,
+                 const std::function<void(std::vector<uint64_t>&)>& pass)
+        {
+            if (!enabled(name))
+                return;
+
+            Result result{name, dataset.name};
+            for (int i = 0; i < m_repeat; ++i) {
+                auto start = Clock::now();
+                pass(result.samples);
+                result.totalNs += nanoseconds(Clock::now() - start);
+                result.bytes += bytesPerPass;
+                result.items += itemsPerPass;
+            }
+            result.peakRss = peakRssKb();
+
+            std::fprintf(stderr, "%-28s %-8s %10.1f MB/s %12.0f items/s\n", name.c_str(), dataset.name.c_str(),
+                result.totalNs ? result.bytes * 1e3 / result.totalNs : 0.0,
+                result.totalNs ? result.items * 1e9 / result.totalNs : 0.0);
+            m_results.push_back(std::move(result));
+        }
+
+        std::string report(const std::string& label, double scale) const
+        {
+            rapidjson::StringBuffer buffer;
+            rapidjson::PrettyWriter<rapidjson::StringBuffer> writer(buffer);
+
+            writer.StartObject();
+            writer.Key("label");
+            writer.String(label.c_str());
+            writer.Key("scale");
+            writer.Double(scale);
+            writer.Key("repeat");
+            writer.Int(m_repeat);
+            writer.Key("peak_rss_kb");
+            writer.Uint64(peakRssKb());
+
+            writer.Key("benchmarks");
+            writer.StartArray();
+            for (const auto& result : m_results) {
+                std::vector<uint64_t> sorted = result.samples;
+                std::sort(sorted.begin(), sorted.end());
+                const double seconds = result.totalNs / 1e9;
+
+                writer.StartObject();
+                writer.Key("name");
+                writer.String(result.name.c_str());
+                writer.Key("dataset");
+                writer.String(result.dataset.c_str());
+                writer.Key("bytes");
+                writer.Uint64(result.bytes);
+                writer.Key("items");
+                writer.Uint64(result.items);
+                writer.Key("seconds");
+                writer.Double(seconds);
+                writer.Key("mb_per_s");
+                writer.Double(seconds > 0 ? result.bytes / 1e6 / seconds : 0.0);
+                writer.Key("items_per_s");
+                writer.Double(seconds > 0 ? result.items / seconds : 0.0);
+                writer.Key("samples");
+                writer.Uint64(sorted.size());
+                writer.Key("p50_ns");
+                writer.Uint64(percentile(sorted, 0.50));
+                writer.Key("p90_ns");
+                writer.Uint64(percentile(sorted, 0.90));
+                writer.Key("p99_ns");
+                writer.Uint64(percentile(sorted, 0.99));
+                writer.Key("max_ns");
+                writer.Uint64(sorted.empty() ? 0 : sorted.back());
+                writer.Key("peak_rss_kb");
+                writer.Uint64(result.peakRss);
+                writer.EndObject();
+            }
+            writer.EndArray();
+            writer.EndObject();
+
+            return std::string(buffer.GetString(), buffer.GetSize()) + "\n";
+        }
+
+    private:
+        int m_repeat;
+        std::string m_filter;
+        std::vector<Result> m_results;
+    };
+
+    // times each call of `op` as one sample
+    template <typename Op>
+    void timeEach(std::vector<uint64_t>& samples, size_t count, Op op)
+    {
+        for (size_t i = 0; i < count; ++i) {
+            auto start = Clock::now();
+            op(i);
+            samples.push_back(nanoseconds(Clock::now() - start));
+        }
+    }
+
+    // times the whole call as one sample
+    template <typename Op>
+    void timeOnce(std::vector<uint64_t>& samples, Op op)
+    {
+        auto start = Clock::now();
+        op();
+        samples.push_back(nanoseconds(Clock::now() - start));
+    }
+
+    size_t expandAll(JsonTreeItem* item)
+    {
+        size_t count = 1;
+        for (int i = 0; i < item->childCount(); ++i)
+            count += expandAll(item->child(i));
+        return count;
+    }
+
+    void benchDataset(Bench& bench, const synthetic::Dataset& dataset)
+    {
+        const std::string_view text = dataset.text;
+
+        // records as found by the sequential scanner
+        std::vector<std::string_view> records;
+        parseSequentialJson(text, [&](size_t, std::string_view record) { records.push_back(record); });
+
+        bench.run("parseSequentialJson", dataset, text.size(), records.size(), [&](std::vector<uint64_t>& samples) {
+            timeOnce(samples, [&]() {
+                size_t count = 0;
+                parseSequentialJson(text, [&](size_t, std::string_view) { ++count; });
+                sink = count;
+            });
+        });
+
+        // the splitter picked on open, memchr only for JSON Lines
+        const JsonFormat format = detectJsonFormat(text);
+        bench.run(std::string("splitJson ") + formatName(format), dataset, text.size(), records.size(), [&](std::vector<uint64_t>& samples) {
+            timeOnce(samples, [&]() {
+                size_t count = 0;
+                splitJson(text, format, [&](size_t, std::string_view) { ++count; }, [](size_t, size_t) {});
+                sink = count;
+            });
+        });
+
+        bench.run("matchJsonValue", dataset, text.size(), records.size(), [&](std::vector<uint64_t>& samples) {
+            timeEach(samples, records.size(), [&](size_t i) {
+                const char* start = records[i].data();
+                auto range = matchJsonValue(start, text.data() + text.size() - start);
+                sink = range ? range->end - range->start : 0;
+            });
+        });
+
+        bench.run("json5.parseNext", dataset, text.size(), records.size(), [&](std::vector<uint64_t>& samples) {
+            timeEach(samples, records.size(), [&](size_t i) {
+                try {
+                    json::Parser parser(records[i]);
+                    sink = parser.parseNext().has_value();
+                } catch (const std::exception&) {
+                    sink = 0;
+                }
+            });
+        });
+
+        // JsonFile works on a mapped file
+        QTemporaryFile file;
+        if (!file.open() || file.write(dataset.text.data(), dataset.text.size()) != qint64(dataset.text.size())) {
+            std::fprintf(stderr, "can't write a temporary file\n");
+            return;
+        }
+        file.flush();
+
+        JsonFile jsonFile;
+        bench.run("JsonFile.line", dataset, text.size(), records.size(), [&](std::vector<uint64_t>& samples) {
+            // reopen so every line is parsed again, open itself is not measured
+            jsonFile.close();
+            jsonFile.open(file.fileName());
+            timeEach(samples, jsonFile.size(), [&](size_t i) {
+                sink = jsonFile.line(i).size;
+            });
+        });
+
+        const std::string needle = "\"needle-that-is-not-there\"";
+        bench.run("search.substring", dataset, text.size(), records.size(), [&](std::vector<uint64_t>& samples) {
+            timeOnce(samples, [&]() {
+                size_t found = 0;
+                for (size_t i = 0; i < jsonFile.size(); ++i)
+                    found += jsonFile.lineText(i).find(needle) != std::string_view::npos;
+                sink = found;
+            });
+        });
+
+        // parsed documents, kept for the rest
+        std::vector<rapidjson::Document> documents(records.size());
+        std::vector<std::vector<JsonSpan>> spans(records.size());
+        for (size_t i = 0; i < records.size(); ++i)
+            parseWithSpans(records[i], documents[i], spans[i]);
+
+        bench.run("toJsonString.truncated", dataset, 0, records.size(), [&](std::vector<uint64_t>& samples) {
+            timeEach(samples, documents.size(), [&](size_t i) {
+                sink = toJsonString(documents[i], MAX_JSON_STRING_LENGTH).size();
+            });
+        });
+
+        bench.run("JsonTreeItem.expandAll", dataset, text.size(), records.size(), [&](std::vector<uint64_t>& samples) {
+            timeEach(samples, documents.size(), [&](size_t i) {
+                JsonTreeStorage storage(JsonSource{records[i], &spans[i]});
+                sink = expandAll(JsonTreeItem::createRoot(&storage, &documents[i]));
+            });
+        });
+
+        // table cells format numbers of the records
+        std::vector<const rapidjson::Value*> numbers;
+        for (const auto& doc : documents) {
+            if (!doc.IsObject())
+                continue;
+            for (auto it = doc.MemberBegin(); it != doc.MemberEnd(); ++it) {
+                if (it->value.IsNumber())
+                    numbers.push_back(&it->value);
+            }
+        }
+
+        auto formatAll = [&](auto format) {
+            return [&, format](std::vector<uint64_t>& samples) {
+                timeOnce(samples, [&]() {
+                    size_t length = 0;
+                    for (const auto* value : numbers)
+                        length += format(*value).size();
+                    sink = length;
+                });
+            };
+        };
+
+        bench.run("format.QLocale", dataset, 0, numbers.size(), formatAll([](const rapidjson::Value& value) {
+            if (value.IsInt64()) return locale.toString(qlonglong(value.GetInt64()));
+            if (value.IsUint64()) return locale.toString(qulonglong(value.GetUint64()));
+            return locale.toString(value.GetDouble());
+        }));
+
+        bench.run("format.NumberFormatter", dataset, 0, numbers.size(), formatAll([](const rapidjson::Value& value) {
+            if (value.IsInt64()) return numberFormatter.toString(value.GetInt64());
+            if (value.IsUint64()) return numberFormatter.toString(value.GetUint64());
+            return numberFormatter.toString(value.GetDouble());
+        }));
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    QCoreApplication app(argc, argv);
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Benchmarks of JsonView parsing, search and formatting.");
+    parser.addHelpOption();
+
+    QCommandLineOption scaleOption("scale", "Dataset size relative to the default.", "factor", "1");
+    QCommandLineOption repeatOption("repeat", "Passes over every dataset.", "count", "3");
+    QCommandLineOption filterOption("filter", "Run only benchmarks containing <name>.", "name");
+    QCommandLineOption datasetOption("dataset", "Run only on <kind>: flat, nested, wide or large.", "kind");
+    QCommandLineOption labelOption("label", "Label stored in the report, e.g. a commit id.", "label");
+    QCommandLineOption outputOption("output", "Write the JSON report to <file> instead of stdout.", "file");
+    parser.addOptions({scaleOption, repeatOption, filterOption, datasetOption, labelOption, outputOption});
+    parser.process(app);
+
+    const double scale = parser.value(scaleOption).toDouble();
+    const int repeat = std::max(1, parser.value(repeatOption).toInt());
+
+    Bench bench(repeat, parser.value(filterOption).toStdString());
+    for (auto kind : synthetic::standardKinds()) {
+        if (parser.isSet(datasetOption) && parser.value(datasetOption).toStdString() != synthetic::kindName(kind))
+            continue;
+
+        auto dataset = synthetic::generate(kind, synthetic::defaultRecords(kind, scale));
+        std::fprintf(stderr, "dataset %s: %zu records, %zu bytes\n", dataset.name.c_str(), dataset.records, dataset.text.size());
+        benchDataset(bench, dataset);
+    }
+
+    const std::string report = bench.report(parser.value(labelOption).toStdString(), scale);
+    if (parser.isSet(outputOption)) {
+        FILE* out = std::fopen(parser.value(outputOption).toLocal8Bit().constData(), "w");
+        if (!out) {
+            std::fprintf(stderr, "can't write %s\n", parser.value(outputOption).toLocal8Bit().constData());
+            return 1;
+        }
+        std::fwrite(report.data(), 1, report.size(), out);
+        std::fclose(out);
+    } else {
+        std::fwrite(report.data(), 1, report.size(), stdout);
+    }
+    return 0;
+}
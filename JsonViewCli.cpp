@@ -0,0 +1,345 @@
+// Command line access to the engine of the viewer, for batch jobs and CI.
+// Records are processed in chunks on all cores, output is streamed in file order.
+//
+//   JsonViewCli count logs.jsonl
+//   JsonViewCli grep timeout logs.jsonl
+//   JsonViewCli grep --field request.status 503 --count logs.jsonl
+//   JsonViewCli project --field id --field user.name logs.jsonl > users.tsv
+//   JsonViewCli index logs.jsonl --output logs.idx
+
+#include "JsonFile.h"
+#include "JsonPath.h"
+#include "json.h"
+
+#include <QCoreApplication>
+#include <QCommandLineParser>
+
+#include <rapidjson/document.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <deque>
+#include <functional>
+#include <future>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+namespace
+{
+    constexpr size_t CHUNK_BYTES = 4 << 20; // records handed to a thread at once
+
+    struct Chunk
+    {
+        size_t first;
+        size_t last; // exclusive
+    };
+
+    struct Output
+    {
+        std::string text;
+        size_t matches = 0;
+    };
+
+    std::vector<Chunk> splitRecords(const JsonFile& file)
+    {
+        std::vector<Chunk> chunks;
+        size_t first = 0;
+        size_t bytes = 0;
+        for (size_t i = 0; i < file.size(); ++i) {
+            bytes += file.lineText(i).size();
+            if (bytes >= CHUNK_BYTES) {
+                chunks.push_back(Chunk{first, i + 1});
+                first = i + 1;
+                bytes = 0;
+            }
+        }
+        if (first < file.size())
+            chunks.push_back(Chunk{first, file.size()});
+        return chunks;
+    }
+
+    // runs `work` on up to two chunks per thread at a time and writes the results in order
+    bool forEachChunk(const JsonFile& file, size_t threads, FILE* out, size_t& matches,
+                      const std::function<void(const Chunk&, Output&)>& work)
+    {
+        const auto chunks = splitRecords(file);
+        std::deque<std::future<Output>> pending;
+        size_t next = 0;
+
+        while (next < chunks.size() || !pending.empty()) {
+            while (next < chunks.size() && pending.size() < threads * 2) {
+                pending.push_back(std::async(std::launch::async, [&work, chunk = chunks[next]]() {
+                    Output output;
+                    work(chunk, output);
+                    return output;
+                }));
+                ++next;
+            }
+
+            Output output = pending.front().get();
+            pending.pop_front();
+            matches += output.matches;
+            if (!output.text.empty() && std::fwrite(output.text.data(), 1, output.text.size(), out) != output.text.size()) {
+                for (auto& future : pending)
+                    future.wait();
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // record holding the byte at `offset` of the mapping
+    size_t recordAt(const JsonFile& file, const Chunk& chunk, size_t offset)
+    {
+        size_t low = chunk.first;
+        size_t high = chunk.last;
+        while (high - low > 1) {
+            size_t middle = low + (high - low) / 2;
+            if (file.lineOffset(middle) <= offset)
+                low = middle;
+            else
+                high = middle;
+        }
+        return low;
+    }
+
+    // scans the text of the whole chunk at once instead of record by record
+    void grepRaw(const JsonFile& file, const Chunk& chunk, std::string_view pattern, const QByteArray& prefix, bool countOnly, Output& output)
+    {
+        const auto contents = file.contents();
+        const size_t begin = file.lineOffset(chunk.first);
+        const size_t end = file.lineOffset(chunk.last - 1) + file.lineText(chunk.last - 1).size();
+        const std::string_view text = contents.substr(begin, end - begin);
+
+        size_t position = 0;
+        while ((position = text.find(pattern, position)) != std::string_view::npos) {
+            size_t record = recordAt(file, chunk, begin + position);
+            const auto line = file.lineText(record);
+            const size_t lineEnd = file.lineOffset(record) + line.size() - begin;
+
+            // a match spanning the gap between records
+            if (position + pattern.size() > lineEnd) {
+                ++position;
+                continue;
+            }
+
+            ++output.matches;
+            if (!countOnly) {
+                output.text.append(prefix.constData(), prefix.size());
+                output.text.append(line);
+                output.text.push_back('\n');
+            }
+            // on past the record, by a byte at least; records of concatenated JSON have no gap
+            position = std::max(lineEnd, position + 1);
+        }
+    }
+
+    bool valueContains(const rapidjson::Value& value, std::string_view pattern)
+    {
+        if (value.IsString())
+            return std::string_view(value.GetString(), value.GetStringLength()).find(pattern) != std::string_view::npos;
+        return toJsonString(value).find(pattern) != std::string::npos;
+    }
+
+    void grepField(const JsonFile& file, const Chunk& chunk, const JsonPath& path, std::string_view pattern, const QByteArray& prefix, bool countOnly, Output& output)
+    {
+        rapidjson::Document doc;
+        for (size_t i = chunk.first; i < chunk.last; ++i) {
+            const auto line = file.lineText(i);
+            if (doc.Parse(line.data(), line.size()).HasParseError())
+                continue;
+
+            const rapidjson::Value* value = path.extract(doc);
+            if (!value || !valueContains(*value, pattern))
+                continue;
+
+            ++output.matches;
+            if (!countOnly) {
+                output.text.append(prefix.constData(), prefix.size());
+                output.text.append(line);
+                output.text.push_back('\n');
+            }
+        }
+    }
+
+    // TSV cell, strings unquoted with tabs and line breaks escaped
+    void appendCell(std::string& out, const rapidjson::Value* value)
+    {
+        if (!value)
+            return;
+
+        if (!value->IsString()) {
+            out += toJsonString(*value);
+            return;
+        }
+
+        const char* p = value->GetString();
+        const char* end = p + value->GetStringLength();
+        for (; p < end; ++p) {
+            switch (*p) {
+                case '\t': out += "\\t"; break;
+                case '\n': out += "\\n"; break;
+                case '\r': out += "\\r"; break;
+                case '\\': out += "\\\\"; break;
+                default: out.push_back(*p);
+            }
+        }
+    }
+
+    void project(const JsonFile& file, const Chunk& chunk, const std::vector<JsonPath>& paths, Output& output)
+    {
+        rapidjson::Document doc;
+        for (size_t i = chunk.first; i < chunk.last; ++i) {
+            const auto line = file.lineText(i);
+            const bool ok = !doc.Parse(line.data(), line.size()).HasParseError();
+
+            for (size_t column = 0; column < paths.size(); ++column) {
+                if (column)
+                    output.text.push_back('\t');
+                appendCell(output.text, ok ? paths[column].extract(doc) : nullptr);
+            }
+            output.text.push_back('\n');
+            ++output.matches;
+        }
+    }
+
+    void index(const JsonFile& file, const Chunk& chunk, const QByteArray& prefix, Output& output)
+    {
+        char buffer[48];
+        for (size_t i = chunk.first; i < chunk.last; ++i) {
+            int length = std::snprintf(buffer, sizeof(buffer), "%zu\t%zu\n", file.lineOffset(i), file.lineText(i).size());
+            output.text.append(prefix.constData(), prefix.size());
+            output.text.append(buffer, length);
+        }
+        output.matches = chunk.last - chunk.first;
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    QCoreApplication app(argc, argv);
+    QCommandLineParser parser;
+    parser.setApplicationDescription(
+        "Headless access to JSON and JSONL files.\n\n"
+        "Commands:\n"
+        "  count <files>              number of records\n"
+        "  grep <text> <files>        records containing <text>, or whose --field contains it\n"
+        "  project <files>            the --field values of every record as TSV\n"
+        "  index <files>              offset and length of every record as TSV");
+    parser.addHelpOption();
+    parser.addPositionalArgument("command", "count, grep, project or index.");
+    parser.addPositionalArgument("files", "Files to read.", "[args] <files>...");
+
+    QCommandLineOption fieldOption("field", "JSON path, e.g. user.name or items[0].id. Repeat to project several columns.", "path");
+    QCommandLineOption countOption("count", "grep: print the number of matching records only.");
+    QCommandLineOption headerOption("no-header", "project: don't print the column paths.");
+    QCommandLineOption threadsOption("threads", "Worker threads.", "count", QString::number(std::max(1u, std::thread::hardware_concurrency())));
+    QCommandLineOption outputOption("output", "Write to <file> instead of stdout.", "file");
+    parser.addOptions({fieldOption, countOption, headerOption, threadsOption, outputOption});
+    parser.process(app);
+
+    auto fail = [](const QString& message) {
+        std::fprintf(stderr, "%s\n", message.toLocal8Bit().constData());
+        return 2;
+    };
+
+    QStringList args = parser.positionalArguments();
+    if (args.isEmpty())
+        return fail("missing command, see --help");
+
+    const QString command = args.takeFirst();
+    QString pattern;
+    if (command == "grep") {
+        if (args.isEmpty())
+            return fail("grep: missing text");
+        pattern = args.takeFirst();
+        if (pattern.isEmpty())
+            return fail("grep: empty text, see --help");
+    } else if (command != "count" && command != "project" && command != "index") {
+        return fail("unknown command " + command);
+    }
+    if (args.isEmpty())
+        return fail(command + ": missing files");
+
+    std::vector<JsonPath> paths;
+    for (const QString& text : parser.values(fieldOption)) {
+        QString error;
+        auto path = JsonPath::compile(text, &error);
+        if (!path)
+            return fail(QString("invalid path '%1': %2").arg(text, error));
+        paths.push_back(std::move(*path));
+    }
+    if (command == "project" && paths.empty())
+        return fail("project: missing --field");
+
+    const size_t threads = std::max(1, parser.value(threadsOption).toInt());
+    const bool countOnly = parser.isSet(countOption);
+    const std::string needle = pattern.toStdString();
+
+    FILE* out = stdout;
+    if (parser.isSet(outputOption)) {
+        out = std::fopen(parser.value(outputOption).toLocal8Bit().constData(), "wb");
+        if (!out)
+            return fail("can't open the output file");
+    }
+
+    if (command == "project" && !parser.isSet(headerOption)) {
+        for (size_t column = 0; column < paths.size(); ++column)
+            std::fprintf(out, "%s%s", column ? "\t" : "", paths[column].text().toUtf8().constData());
+        std::fputc('\n', out);
+    }
+
+    // like grep, name the file when reading several
+    const bool named = args.size() > 1;
+    size_t total = 0;
+    JsonFile file;
+
+    for (const QString& name : args) {
+        file.close();
+        if (!file.open(name)) {
+            std::fprintf(stderr, "can't open %s\n", name.toLocal8Bit().constData());
+            return 2;
+        }
+
+        const QByteArray prefix = named ? name.toUtf8() + '\t' : QByteArray();
+        size_t matches = 0;
+        bool ok = true;
+
+        if (command == "count") {
+            matches = file.size();
+        } else if (command == "grep" && paths.empty()) {
+            ok = forEachChunk(file, threads, out, matches, [&](const Chunk& chunk, Output& output) {
+                grepRaw(file, chunk, needle, prefix, countOnly, output);
+            });
+        } else if (command == "grep") {
+            ok = forEachChunk(file, threads, out, matches, [&](const Chunk& chunk, Output& output) {
+                grepField(file, chunk, paths.front(), needle, prefix, countOnly, output);
+            });
+        } else if (command == "project") {
+            ok = forEachChunk(file, threads, out, matches, [&](const Chunk& chunk, Output& output) {
+                project(file, chunk, paths, output);
+            });
+        } else {
+            ok = forEachChunk(file, threads, out, matches, [&](const Chunk& chunk, Output& output) {
+                index(file, chunk, prefix, output);
+            });
+        }
+
+        if (!ok)
+            return fail("write failed");
+
+        if (command == "count" || countOnly)
+            std::fprintf(out, "%s%zu\n", prefix.constData(), matches);
+        total += matches;
+    }
+
+    if (out != stdout)
+        std::fclose(out);
+    else
+        std::fflush(out);
+
+    // grep convention: 1 when nothing matched
+    return command == "grep" && total == 0 ? 1 : 0;
+}
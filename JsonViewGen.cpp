@@ -0,0 +1,174 @@
+// Generates synthetic JSONL files for scale testing. Output depends only on the options
+// and the seed, not on the number of threads.
+//
+//   JsonViewGen --kind log --size 2G --threads 8 --output logs.jsonl
+//   JsonViewGen --kind mixed --layout mixed --records 100000 --seed 7 > mixed.json
+
+#include "SyntheticData.h"
+
+#include <QCoreApplication>
+#include <QCommandLineParser>
+
+#include <algorithm>
+#include <cstdio>
+#include <future>
+#include <limits>
+#include <thread>
+#include <vector>
+
+namespace
+{
+    // accepts plain bytes or K, M and G suffixes
+    std::optional<uint64_t> parseSize(const QString& text)
+    {
+        if (text.isEmpty())
+            return std::nullopt;
+
+        uint64_t multiplier = 1;
+        QString number = text;
+        switch (text.back().toUpper().toLatin1()) {
+            case 'K': multiplier = 1ULL << 10; break;
+            case 'M': multiplier = 1ULL << 20; break;
+            case 'G': multiplier = 1ULL << 30; break;
+        }
+        if (multiplier != 1)
+            number.chop(1);
+
+        bool ok = false;
+        double value = number.toDouble(&ok);
+        if (!ok || value < 0)
+            return std::nullopt;
+        return static_cast<uint64_t>(value * multiplier);
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    QCoreApplication app(argc, argv);
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Deterministic synthetic JSON datasets.");
+    parser.addHelpOption();
+
+    QStringList kinds;
+    for (auto kind : synthetic::allKinds())
+        kinds << QString::fromUtf8(synthetic::kindName(kind).data(), synthetic::kindName(kind).size());
+
+    QCommandLineOption kindOption("kind", "Record kind: " + kinds.join(", ") + ".", "kind", "log");
+    QCommandLineOption layoutOption("layout", "lines, concatenated, pretty or mixed.", "layout", "lines");
+    QCommandLineOption recordsOption("records", "Number of records.", "count");
+    QCommandLineOption sizeOption("size", "Stop after about <size> bytes, e.g. 512M or 2G.", "size");
+    QCommandLineOption seedOption("seed", "Seed of the dataset.", "seed", "1");
+    QCommandLineOption threadsOption("threads", "Generator threads.", "count", QString::number(std::max(1u, std::thread::hardware_concurrency())));
+    QCommandLineOption keysOption("keys", "Top level keys of wide records.", "count", "400");
+    QCommandLineOption depthOption("depth", "Nesting of deep records.", "levels", "64");
+    QCommandLineOption arrayOption("array-length", "Numbers in arrays of large records.", "count", "100000");
+    QCommandLineOption stringOption("string-length", "Bytes of strings in large and escaped records.", "size", "1M");
+    QCommandLineOption recordSizeOption("record-size", "Bytes of document records.", "size", "5M");
+    QCommandLineOption outputOption("output", "Write to <file> instead of stdout.", "file");
+    parser.addOptions({kindOption, layoutOption, recordsOption, sizeOption, seedOption, threadsOption,
+                       keysOption, depthOption, arrayOption, stringOption, recordSizeOption, outputOption});
+    parser.process(app);
+
+    auto fail = [](const char* message) {
+        std::fprintf(stderr, "%s\n", message);
+        return 1;
+    };
+
+    auto kind = synthetic::kindFromName(parser.value(kindOption).toStdString());
+    if (!kind)
+        return fail("unknown --kind");
+
+    auto layout = synthetic::layoutFromName(parser.value(layoutOption).toStdString());
+    if (!layout)
+        return fail("unknown --layout");
+
+    synthetic::Options options;
+    options.layout = *layout;
+    options.wideKeys = parser.value(keysOption).toULongLong();
+    options.depth = parser.value(depthOption).toULongLong();
+    options.arrayLength = parser.value(arrayOption).toULongLong();
+    auto stringLength = parseSize(parser.value(stringOption));
+    auto recordBytes = parseSize(parser.value(recordSizeOption));
+    if (!stringLength || !recordBytes)
+        return fail("invalid --string-length or --record-size");
+    options.stringLength = *stringLength;
+    options.recordBytes = *recordBytes;
+
+    // by default a dataset of typical size for the kind
+    uint64_t records = synthetic::defaultRecords(*kind);
+    uint64_t maxBytes = std::numeric_limits<uint64_t>::max();
+    if (parser.isSet(sizeOption)) {
+        auto size = parseSize(parser.value(sizeOption));
+        if (!size)
+            return fail("invalid --size");
+        maxBytes = *size;
+        records = std::numeric_limits<uint64_t>::max();
+    }
+    if (parser.isSet(recordsOption))
+        records = parser.value(recordsOption).toULongLong();
+
+    const uint64_t seed = parser.value(seedOption).toULongLong();
+    const size_t threads = std::max(1, parser.value(threadsOption).toInt());
+
+    FILE* out = stdout;
+    if (parser.isSet(outputOption)) {
+        out = std::fopen(parser.value(outputOption).toLocal8Bit().constData(), "wb");
+        if (!out)
+            return fail("can't open the output file");
+    }
+
+    // chunks are generated in rounds, one per thread, and written in order
+    const size_t perChunk = synthetic::chunkRecords(*kind, options);
+    uint64_t written = 0;
+    uint64_t recordsWritten = 0;
+    size_t chunk = 0;
+    bool done = records == 0;
+
+    while (!done) {
+        std::vector<std::future<synthetic::Chunk>> round;
+        for (size_t i = 0; i < threads; ++i, ++chunk) {
+            uint64_t first = uint64_t(chunk) * perChunk;
+            if (first >= records)
+                break;
+            size_t count = static_cast<size_t>(std::min<uint64_t>(perChunk, records - first));
+            round.push_back(std::async(std::launch::async, synthetic::generateChunk, *kind, options, seed, chunk, count));
+        }
+        if (round.empty())
+            break;
+
+        for (auto& future : round) {
+            synthetic::Chunk result = future.get();
+            if (done)
+                continue; // let the rest of the round finish
+
+            // stop at the first record reaching the size limit
+            size_t length = result.text.size();
+            size_t count = result.ends.size();
+            if (written + length >= maxBytes) {
+                auto end = std::lower_bound(result.ends.begin(), result.ends.end(), maxBytes - written);
+                count = std::min<size_t>(result.ends.size(), end - result.ends.begin() + 1);
+                length = result.ends[count - 1];
+                done = true;
+            }
+
+            if (std::fwrite(result.text.data(), 1, length, out) != length) {
+                std::fclose(out);
+                return fail("write failed");
+            }
+            written += length;
+            recordsWritten += count;
+        }
+
+        if (uint64_t(chunk) * perChunk >= records)
+            done = true;
+    }
+
+    if (out != stdout)
+        std::fclose(out);
+    else
+        std::fflush(out);
+
+    std::fprintf(stderr, "%s: %llu records, %llu bytes\n", parser.value(kindOption).toUtf8().constData(),
+        static_cast<unsigned long long>(recordsWritten), static_cast<unsigned long long>(written));
+    return 0;
+}
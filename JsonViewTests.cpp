@@ -0,0 +1,342 @@
+// Checks of the non-GUI core on seeded synthetic data, run by ctest.
+// Every failed check is printed, the exit code is the number of failures.
+
+#include "json.h"
+#include "GroupBy.h"
+#include "StructuralIndex.h"
+#include "SyntheticData.h"
+#include "constants.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace
+{
+    int failures = 0;
+
+    void check(bool condition, const char* text, const std::string& context, int line)
+    {
+        if (condition)
+            return;
+        std::fprintf(stderr, "line %d: %s failed (%s)\n", line, text, context.c_str());
+        ++failures;
+    }
+
+#define CHECK(condition, context) check((condition), #condition, (context), __LINE__)
+
+    const size_t RECORDS = 300;
+
+    // small records of every kind, so the whole run takes a moment
+    synthetic::Options smallOptions(synthetic::Layout layout)
+    {
+        synthetic::Options options;
+        options.layout = layout;
+        options.wideKeys = 40;
+        options.depth = 12;
+        options.arrayLength = 200;
+        options.stringLength = 300;
+        options.recordBytes = 8 * 1024;
+        return options;
+    }
+
+    // text of a file, offset and length of its records and of the bytes skipped in it
+    struct Expected
+    {
+        std::string text;
+        std::vector<std::pair<size_t, size_t>> records;
+        std::vector<std::pair<size_t, size_t>> skipped;
+    };
+
+    // the dataset of synthetic::generate, with records located by the ends of its chunks
+    Expected generated(synthetic::Kind kind, synthetic::Layout layout)
+    {
+        const auto options = smallOptions(layout);
+        const size_t perChunk = synthetic::chunkRecords(kind, options);
+
+        Expected expected;
+        for (size_t chunk = 0; chunk * perChunk < RECORDS; ++chunk) {
+            auto part = synthetic::generateChunk(kind, options, 7, chunk, std::min(perChunk, RECORDS - chunk * perChunk));
+            size_t start = 0;
+            for (size_t end : part.ends) {
+                auto record = std::string_view(part.text).substr(start, end - start);
+                const size_t first = record.find_first_not_of(" \t\r\n");
+                const size_t last = record.find_last_not_of(" \t\r\n");
+                expected.records.emplace_back(expected.text.size() + start + first, last + 1 - first);
+                start = end;
+            }
+            expected.text += part.text;
+        }
+        return expected;
+    }
+
+    // the records of a lines layout rewritten as one array or an RFC 7464 sequence
+    Expected rewritten(const Expected& lines, JsonFormat format)
+    {
+        Expected expected;
+        if (format == JsonFormat::Array)
+            expected.text = "[\n";
+        for (size_t i = 0; i < lines.records.size(); ++i) {
+            auto [offset, length] = lines.records[i];
+            if (format == JsonFormat::Array && i)
+                expected.text += ",\n";
+            if (format == JsonFormat::Sequence)
+                expected.text += '\x1e';
+            expected.records.emplace_back(expected.text.size(), length);
+            expected.text.append(lines.text, offset, length);
+            if (format == JsonFormat::Sequence)
+                expected.text += '\n';
+        }
+        if (format == JsonFormat::Array)
+            expected.text += "\n]\n";
+        return expected;
+    }
+
+    // `garbage` inserted before record `at`, later records move by its size
+    void insert(Expected& expected, size_t at, std::string_view garbage)
+    {
+        const size_t offset = expected.records[at].first;
+        expected.text.insert(offset, garbage);
+        for (size_t i = at; i < expected.records.size(); ++i)
+            expected.records[i].first += garbage.size();
+        expected.skipped.emplace_back(offset, garbage.size());
+    }
+
+    void checkSplit(const Expected& expected, JsonFormat format, const std::string& context)
+    {
+        std::vector<std::pair<size_t, size_t>> records;
+        std::vector<std::pair<size_t, size_t>> skipped;
+        const std::string_view data = expected.text;
+        splitJson(data, format, [&](size_t index, std::string_view record) {
+            CHECK(index == records.size(), context);
+            records.emplace_back(record.data() - data.data(), record.size());
+        }, [&](size_t offset, size_t length) {
+            skipped.emplace_back(offset, length);
+        });
+
+        CHECK(records.size() == expected.records.size(), context);
+        CHECK(records == expected.records, context);
+        CHECK(skipped == expected.skipped, context);
+    }
+
+    void testLayouts()
+    {
+        using synthetic::Layout;
+        const std::pair<Layout, JsonFormat> layouts[] = {
+            {Layout::Lines, JsonFormat::Lines},
+            {Layout::Concatenated, JsonFormat::Concatenated},
+            {Layout::Pretty, JsonFormat::Concatenated},
+        };
+
+        for (auto kind : synthetic::allKinds()) {
+            for (auto [layout, format] : layouts) {
+                const std::string context = std::string(synthetic::kindName(kind)) + " " + std::string(synthetic::layoutName(layout));
+                auto expected = generated(kind, layout);
+                CHECK(synthetic::generate(kind, RECORDS, 7, smallOptions(layout)).text == expected.text, context);
+                CHECK(detectJsonFormat(expected.text) == format, context);
+                checkSplit(expected, format, context);
+                // any layout is a valid concatenation of values
+                checkSplit(expected, JsonFormat::Concatenated, context + " as concatenated");
+            }
+
+            // a mix of layouts can only be read as concatenated values
+            const std::string context = std::string(synthetic::kindName(kind)) + " mixed";
+            checkSplit(generated(kind, Layout::Mixed), JsonFormat::Concatenated, context);
+
+            auto lines = generated(kind, Layout::Lines);
+            for (auto format : {JsonFormat::Array, JsonFormat::Sequence}) {
+                const std::string context = std::string(synthetic::kindName(kind)) + " " + formatName(format);
+                auto expected = rewritten(lines, format);
+                CHECK(detectJsonFormat(expected.text) == format, context);
+                checkSplit(expected, format, context);
+            }
+        }
+    }
+
+    void testBrokenRecords()
+    {
+        // NDJSON resyncs at the next line starting a record, before and after the first error
+        auto lines = generated(synthetic::Kind::Nested, synthetic::Layout::Lines);
+        insert(lines, 10, "{\"broken\": tru\n");
+        insert(lines, 20, "not json at all\n");
+        // closed five lines later, matched to there it would swallow the records between
+        insert(lines, 30, "{\"open\": 1\n");
+        insert(lines, 35, "}\n");
+        insert(lines, RECORDS - 1, "[1, 2,\n");
+        checkSplit(lines, JsonFormat::Concatenated, "broken lines");
+
+        // a byte order mark is not a record, offsets still count it
+        Expected marked = lines;
+        marked.text.insert(0, "\xEF\xBB\xBF");
+        for (auto& record : marked.records)
+            record.first += 3;
+        for (auto& skipped : marked.skipped)
+            skipped.first += 3;
+        CHECK(detectJsonFormat(marked.text) == JsonFormat::Lines, "byte order mark");
+        checkSplit(marked, JsonFormat::Concatenated, "byte order mark");
+
+        // elements after a broken one are skipped with the rest of the array
+        auto array = rewritten(generated(synthetic::Kind::Flat, synthetic::Layout::Lines), JsonFormat::Array);
+        const size_t broken = array.records[5].first;
+        array.text.insert(broken, "{\"broken\": ");
+        array.records.resize(5);
+        array.skipped.emplace_back(broken, array.text.size() - broken);
+        checkSplit(array, JsonFormat::Array, "broken array");
+
+        // text before the first record separator
+        auto sequence = rewritten(generated(synthetic::Kind::Flat, synthetic::Layout::Lines), JsonFormat::Sequence);
+        sequence.text.insert(0, "junk\n");
+        for (auto& record : sequence.records)
+            record.first += 5;
+        sequence.skipped.emplace_back(0, 5);
+        checkSplit(sequence, JsonFormat::Sequence, "sequence preamble");
+
+        CHECK(detectJsonFormat("") == JsonFormat::Lines, "empty");
+        CHECK(detectJsonFormat("[1, 2, 3]") == JsonFormat::Array, "one line array");
+        CHECK(detectJsonFormat("[1]\n[2]\n") == JsonFormat::Lines, "arrays per line");
+    }
+
+    void testStructuralIndex()
+    {
+        // every record large enough to be indexed is a node of the document
+        const size_t minBytes = 256;
+        auto lines = generated(synthetic::Kind::Nested, synthetic::Layout::Lines);
+        auto array = rewritten(lines, JsonFormat::Array);
+        std::string document = "{\"count\": 300, \"records\": " + array.text + "}";
+        const size_t base = document.find('[');
+        StructuralIndex index(document, minBytes);
+
+        CHECK(index.valid(), "document");
+        CHECK(index.isObject(0), "document");
+        CHECK(index.node(0).offset == 0 && index.node(0).length == document.size(), "document");
+        CHECK(index.node(0).children == 2, "document");
+
+        std::vector<StructuralIndex::Child> members;
+        index.forEachChild(0, 0, [&](const StructuralIndex::Child& child) {
+            members.push_back(child);
+            return true;
+        });
+        CHECK(members.size() == 2, "members");
+        if (members.size() != 2)
+            return;
+        CHECK(members[0].key == "\"count\"" && members[0].value == "300" && members[0].node == StructuralIndex::NO_NODE, "members");
+        CHECK(members[1].key == "\"records\"" && members[1].offset == document.find("\"records\""), "members");
+        CHECK(members[1].node != StructuralIndex::NO_NODE && members[1].value.size() == array.text.find_last_of(']') + 1, "members");
+
+        const uint32_t records = members[1].node;
+        CHECK(!index.isObject(records) && index.node(records).children == RECORDS, "records");
+        size_t visited = 0;
+        index.forEachChild(records, 0, [&](const StructuralIndex::Child& child) {
+            const std::string context = "record " + std::to_string(visited);
+            auto [offset, length] = array.records[visited];
+            CHECK(child.key.empty() && child.offset == base + offset && child.value.size() == length, context);
+            CHECK((child.node != StructuralIndex::NO_NODE) == (length >= minBytes), context);
+            if (child.node != StructuralIndex::NO_NODE)
+                CHECK(index.source(child.node) == child.value, context);
+            ++visited;
+            return true;
+        });
+        CHECK(visited == RECORDS, "records");
+
+        // listing from the middle starts at the child there and stops when asked to
+        std::vector<size_t> offsets;
+        index.forEachChild(records, base + array.records[100].first, [&](const StructuralIndex::Child& child) {
+            offsets.push_back(child.offset - base);
+            return offsets.size() < 3;
+        });
+        CHECK(offsets.size() == 3 && offsets[0] == array.records[100].first && offsets[2] == array.records[102].first, "from");
+
+        // a subtree holds the nodes up to its skip pointer and no other
+        for (uint32_t i = 0; i < index.size(); ++i) {
+            const auto& node = index.node(i);
+            const size_t end = node.offset + node.length;
+            CHECK(node.next > i && node.next <= index.size(), "skip pointer");
+            for (uint32_t j = i + 1; j < node.next && j < index.size(); ++j)
+                CHECK(index.node(j).offset + index.node(j).length <= end, "skip pointer");
+            if (node.next < index.size())
+                CHECK(index.node(node.next).offset >= end, "skip pointer");
+        }
+
+        CHECK(!StructuralIndex("{\"a\": [1, 2", minBytes).valid(), "unclosed");
+        CHECK(!StructuralIndex("\"text\"", minBytes).valid(), "scalar");
+        CHECK(StructuralIndex(" [] ", minBytes).node(0).children == 0, "empty");
+    }
+
+    void testQuantiles()
+    {
+        const std::pair<const char*, double> valid[] = {
+            {"p1", 0.01}, {"p5", 0.05}, {"p50", 0.5}, {"p99", 0.99}, {"p100", 1.0}, {"p999", 0.999}, {"p9999", 0.9999},
+        };
+        for (auto [function, quantile] : valid) {
+            auto query = GroupByQuery::parse("status", QString("%1(latency)").arg(function));
+            CHECK(query && query->aggregates.size() == 1, function);
+            if (query && query->aggregates.size() == 1) {
+                CHECK(query->aggregates[0].function == GroupByQuery::Function::Quantile, function);
+                CHECK(std::abs(query->aggregates[0].quantile - quantile) < 1e-12, function);
+            }
+        }
+
+        for (const char* function : {"p0", "p150", "p990", "p5x", "p"}) {
+            QString error;
+            CHECK(!GroupByQuery::parse("status", QString("%1(latency)").arg(function), &error), function);
+            CHECK(!error.isEmpty(), function);
+        }
+    }
+
+    void testGroupRows()
+    {
+        // popular groups fill the row budget, later keys still get groups of their own
+        auto query = GroupByQuery::parse("key", "count, p50(value)");
+        CHECK(query.has_value(), "group rows");
+        if (!query)
+            return;
+
+        const size_t popular = GROUP_BY_ROWS_BUDGET / sizeof(size_t) / GROUP_BY_MAX_ROWS + 100;
+        const size_t distinct = 5000;
+        GroupTable table(&*query);
+        rapidjson::Document record;
+        record.SetObject();
+        record.AddMember("key", rapidjson::Value(), record.GetAllocator());
+        record.AddMember("value", 1, record.GetAllocator());
+
+        size_t row = 0;
+        auto add = [&](size_t key) {
+            const std::string text = std::to_string(key);
+            record["key"].SetString(rapidjson::StringRef(text.data(), text.size()));
+            table.add(row++, record);
+        };
+        for (size_t i = 0; i < popular * GROUP_BY_MAX_ROWS; ++i)
+            add(i % popular);
+        for (size_t i = 0; i < distinct; ++i)
+            add(popular + i);
+
+        size_t rows = 0;
+        size_t records = 0;
+        for (const auto* group : table.groups()) {
+            rows += group->rows.size();
+            records += group->records;
+        }
+        CHECK(!table.approximate(), "group rows");
+        CHECK(table.groups().size() == popular + distinct, "group rows");
+        CHECK(records == row, "group rows");
+        CHECK(rows == GROUP_BY_ROWS_BUDGET / sizeof(size_t), "group rows");
+    }
+}
+
+int main()
+{
+    testLayouts();
+    testBrokenRecords();
+    testStructuralIndex();
+    testQuantiles();
+    testGroupRows();
+
+    if (failures)
+        std::fprintf(stderr, "%d checks failed\n", failures);
+    else
+        std::fprintf(stderr, "all checks passed\n");
+    return failures;
+}
@@ -0,0 +1,364 @@
+#include "LargeTextView.h"
+
+#include <QInputDialog>
+#include <QKeyEvent>
+#include <QPainter>
+#include <QScrollBar>
+
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+
+LargeTextView::LargeTextView(QWidget* parent)
+    : QAbstractScrollArea(parent)
+{
+    setFocusPolicy(Qt::StrongFocus);
+    viewport()->setBackgroundRole(QPalette::Base);
+
+    // index the rest in background steps, the scroll range grows meanwhile
+    m_indexer.setInterval(0);
+    connect(&m_indexer, &QTimer::timeout, this, [this]() {
+        indexStep(INDEX_STEP);
+        if (isIndexed())
+            m_indexer.stop();
+        updateScrollBars();
+    });
+}
+
+void LargeTextView::setText(const QByteArray& text)
+{
+    m_text = text;
+    m_lines.clear();
+    m_states.clear();
+    m_state = 0;
+    m_indexed = 0;
+    m_matchOffset = -1;
+    m_matchLength = 0;
+
+    verticalScrollBar()->setValue(0);
+    horizontalScrollBar()->setValue(0);
+
+    indexStep(INDEX_STEP);
+    if (!isIndexed())
+        m_indexer.start();
+    updateScrollBars();
+    viewport()->update();
+}
+
+void LargeTextView::indexStep(qsizetype budget)
+{
+    const char* data = m_text.constData();
+    const qsizetype size = m_text.size();
+    const qsizetype stop = std::min(size, m_indexed + budget);
+
+    while (m_indexed < size && m_indexed < stop) {
+        const qsizetype start = m_indexed;
+        m_lines.push_back(start);
+
+        qsizetype limit = std::min(size, m_indexed + WRAP_BYTES);
+        auto* newline = static_cast<const char*>(memchr(data + m_indexed, '\n', limit - m_indexed));
+        if (newline) {
+            m_indexed = newline - data + 1;
+        } else {
+            // wrap, without splitting a utf-8 sequence
+            qsizetype next = limit;
+            while (next < size && next > m_indexed + 1 && (static_cast<unsigned char>(data[next]) & 0xC0) == 0x80)
+                --next;
+            m_indexed = next;
+        }
+
+        if (m_highlighting) {
+            m_states.push_back(m_state);
+            m_state = advance(std::string_view(data + start, m_indexed - start), m_state);
+        }
+    }
+}
+
+uint8_t LargeTextView::advance(std::string_view bytes, uint8_t state)
+{
+    for (char c : bytes) {
+        if (!(state & InString)) {
+            if (c == '"')
+                state = InString;
+        } else if (state & Escaped) {
+            state = InString;
+        } else if (c == '\\') {
+            state = InString | Escaped;
+        } else if (c == '"') {
+            state = 0;
+        }
+    }
+    return state;
+}
+
+void LargeTextView::tokenize(std::string_view bytes, uint8_t state, std::vector<Run>& runs)
+{
+    runs.clear();
+    const qsizetype size = bytes.size();
+    qsizetype pos = 0;
+
+    // rest of a string, `pos` is after the opening quote or at the line start
+    auto stringEnd = [&](qsizetype pos, bool escaped) {
+        for (; pos < size; ++pos) {
+            if (escaped)
+                escaped = false;
+            else if (bytes[pos] == '\\')
+                escaped = true;
+            else if (bytes[pos] == '"')
+                return pos + 1;
+        }
+        return size;
+    };
+
+    if (state & InString) {
+        pos = stringEnd(0, state & Escaped);
+        runs.push_back(Run{pos, Token::String});
+    }
+
+    while (pos < size) {
+        const char c = bytes[pos];
+        const qsizetype start = pos;
+        Token token = Token::Plain;
+
+        if (c == '"') {
+            pos = stringEnd(pos + 1, false);
+            // a key when a colon follows on the same line
+            qsizetype next = pos;
+            while (next < size && (bytes[next] == ' ' || bytes[next] == '\t'))
+                ++next;
+            token = next < size && bytes[next] == ':' ? Token::Key : Token::String;
+        } else if (c == '-' || (c >= '0' && c <= '9')) {
+            while (pos < size && (std::isdigit(static_cast<unsigned char>(bytes[pos])) || std::strchr("+-.eE", bytes[pos])))
+                ++pos;
+            token = Token::Number;
+        } else if (std::isalpha(static_cast<unsigned char>(c))) {
+            while (pos < size && std::isalpha(static_cast<unsigned char>(bytes[pos])))
+                ++pos;
+            token = Token::Literal;
+        } else if (std::strchr("{}[],:", c)) {
+            ++pos;
+            token = Token::Punctuation;
+        } else {
+            // whitespace and anything unexpected, up to the next token
+            while (pos < size && !std::strchr("\"{}[],:-", bytes[pos])
+                   && !std::isalnum(static_cast<unsigned char>(bytes[pos])))
+                ++pos;
+            if (pos == start)
+                ++pos;
+        }
+
+        // merge with the previous run of the same kind
+        if (!runs.empty() && runs.back().token == token)
+            runs.back().length += pos - start;
+        else
+            runs.push_back(Run{pos - start, token});
+    }
+}
+
+QColor LargeTextView::color(Token token) const
+{
+    // darker colors on light backgrounds, lighter on dark ones
+    const bool dark = palette().color(QPalette::Base).lightness() < 128;
+    switch (token) {
+        case Token::Key: return dark ? QColor(0x9c, 0xdc, 0xfe) : QColor(0x00, 0x45, 0x8b);
+        case Token::String: return dark ? QColor(0xce, 0x91, 0x78) : QColor(0xa3, 0x15, 0x15);
+        case Token::Number: return dark ? QColor(0xb5, 0xce, 0xa8) : QColor(0x09, 0x86, 0x58);
+        case Token::Literal: return dark ? QColor(0x56, 0x9c, 0xd6) : QColor(0x00, 0x00, 0xff);
+        case Token::Punctuation:
+        case Token::Plain: break;
+    }
+    return palette().color(QPalette::Text);
+}
+
+void LargeTextView::indexUntil(qsizetype offset)
+{
+    if (m_indexed <= offset)
+        indexStep(offset - m_indexed + WRAP_BYTES);
+    if (isIndexed())
+        m_indexer.stop();
+    updateScrollBars();
+}
+
+int LargeTextView::lineOf(qsizetype offset) const
+{
+    auto it = std::upper_bound(m_lines.begin(), m_lines.end(), offset);
+    return std::max(0, static_cast<int>(it - m_lines.begin()) - 1);
+}
+
+std::string_view LargeTextView::line(int index) const
+{
+    qsizetype start = m_lines[index];
+    qsizetype end = index + 1 < lineCount() ? m_lines[index + 1] : m_indexed;
+    if (end > start && m_text[end - 1] == '\n')
+        --end;
+    return std::string_view(m_text.constData() + start, end - start);
+}
+
+int LargeTextView::visibleLines() const
+{
+    return std::max(1, viewport()->height() / fontMetrics().lineSpacing());
+}
+
+void LargeTextView::updateScrollBars()
+{
+    const int visible = visibleLines();
+    verticalScrollBar()->setPageStep(visible);
+    verticalScrollBar()->setRange(0, std::max(0, lineCount() - visible));
+
+    // lines are at most WRAP_BYTES long
+    const int width = fontMetrics().averageCharWidth() * WRAP_BYTES;
+    horizontalScrollBar()->setPageStep(viewport()->width());
+    horizontalScrollBar()->setRange(0, std::max(0, width - viewport()->width()));
+}
+
+void LargeTextView::resizeEvent(QResizeEvent* event)
+{
+    QAbstractScrollArea::resizeEvent(event);
+    updateScrollBars();
+}
+
+void LargeTextView::paintEvent(QPaintEvent*)
+{
+    QPainter painter(viewport());
+    const QFontMetrics metrics = fontMetrics();
+    const int lineHeight = metrics.lineSpacing();
+    const int x = -horizontalScrollBar()->value() + 2;
+
+    const int first = verticalScrollBar()->value();
+    const int last = std::min(lineCount(), first + visibleLines() + 1);
+    std::vector<Run> runs;
+
+    for (int i = first; i < last; ++i) {
+        const int y = (i - first) * lineHeight;
+        const auto bytes = line(i);
+        const qsizetype start = m_lines[i];
+
+        // highlight the part of the match on this line
+        if (m_matchOffset >= 0 && m_matchOffset < start + qsizetype(bytes.size()) && m_matchOffset + m_matchLength > start) {
+            qsizetype from = std::max(m_matchOffset, start) - start;
+            qsizetype to = std::min(m_matchOffset + m_matchLength, start + qsizetype(bytes.size())) - start;
+            int left = metrics.horizontalAdvance(QString::fromUtf8(bytes.data(), from));
+            int width = metrics.horizontalAdvance(QString::fromUtf8(bytes.data() + from, to - from));
+            painter.fillRect(x + left, y, width, lineHeight, palette().color(QPalette::Highlight));
+        }
+
+        if (!m_highlighting || i >= qsizetype(m_states.size())) {
+            painter.drawText(x, y + metrics.ascent(), QString::fromUtf8(bytes.data(), bytes.size()));
+            continue;
+        }
+
+        tokenize(bytes, m_states[i], runs);
+        int left = x;
+        qsizetype offset = 0;
+        for (const Run& run : runs) {
+            const QString text = QString::fromUtf8(bytes.data() + offset, run.length);
+            painter.setPen(color(run.token));
+            painter.drawText(left, y + metrics.ascent(), text);
+            left += metrics.horizontalAdvance(text);
+            offset += run.length;
+        }
+    }
+}
+
+void LargeTextView::showRange(qsizetype offset, qsizetype length)
+{
+    m_matchOffset = std::clamp<qsizetype>(offset, 0, m_text.size());
+    m_matchLength = length;
+    scrollToMatch();
+}
+
+void LargeTextView::scrollToMatch()
+{
+    indexUntil(m_matchOffset);
+    const int line = lineOf(m_matchOffset);
+
+    const int first = verticalScrollBar()->value();
+    if (line < first || line >= first + visibleLines())
+        verticalScrollBar()->setValue(line - visibleLines() / 2);
+
+    const auto bytes = line < lineCount() ? this->line(line) : std::string_view();
+    const qsizetype column = std::min<qsizetype>(m_matchOffset - m_lines[line], bytes.size());
+    const int left = fontMetrics().horizontalAdvance(QString::fromUtf8(bytes.data(), column));
+    if (left < horizontalScrollBar()->value() || left > horizontalScrollBar()->value() + viewport()->width())
+        horizontalScrollBar()->setValue(left - viewport()->width() / 2);
+
+    viewport()->update();
+}
+
+bool LargeTextView::find(const QString& query, bool forward)
+{
+    if (query.isEmpty() || m_text.isEmpty())
+        return false;
+
+    m_query = query;
+    const QByteArray needle = query.toUtf8();
+    const std::string_view text(m_text.constData(), m_text.size());
+    const std::string_view pattern(needle.constData(), needle.size());
+
+    // continue from the current match, or from the top of the view
+    qsizetype from = m_matchOffset >= 0
+        ? m_matchOffset
+        : (lineCount() ? m_lines[verticalScrollBar()->value()] : 0);
+
+    size_t found;
+    if (forward) {
+        found = text.find(pattern, m_matchOffset >= 0 ? from + 1 : from);
+        if (found == std::string_view::npos)
+            found = text.find(pattern); // wrap around
+    } else {
+        found = from > 0 ? text.rfind(pattern, from - 1) : std::string_view::npos;
+        if (found == std::string_view::npos)
+            found = text.rfind(pattern);
+    }
+
+    if (found == std::string_view::npos) {
+        m_matchOffset = -1;
+        m_matchLength = 0;
+        viewport()->update();
+        emit matchNotFound(query);
+        return false;
+    }
+
+    m_matchOffset = static_cast<qsizetype>(found);
+    m_matchLength = needle.size();
+    scrollToMatch();
+    return true;
+}
+
+void LargeTextView::keyPressEvent(QKeyEvent* event)
+{
+    if (event->matches(QKeySequence::Find)) {
+        bool ok = false;
+        QString query = QInputDialog::getText(this, "Find in value", "Text:", QLineEdit::Normal, m_query, &ok);
+        if (ok && !query.isEmpty()) {
+            m_matchOffset = -1;
+            find(query);
+        }
+        return;
+    }
+
+    if (event->matches(QKeySequence::FindNext)) {
+        find(m_query, true);
+        return;
+    }
+
+    if (event->matches(QKeySequence::FindPrevious)) {
+        find(m_query, false);
+        return;
+    }
+
+    switch (event->key()) {
+        case Qt::Key_Up: verticalScrollBar()->triggerAction(QAbstractSlider::SliderSingleStepSub); return;
+        case Qt::Key_Down: verticalScrollBar()->triggerAction(QAbstractSlider::SliderSingleStepAdd); return;
+        case Qt::Key_PageUp: verticalScrollBar()->triggerAction(QAbstractSlider::SliderPageStepSub); return;
+        case Qt::Key_PageDown: verticalScrollBar()->triggerAction(QAbstractSlider::SliderPageStepAdd); return;
+        case Qt::Key_Home: verticalScrollBar()->triggerAction(QAbstractSlider::SliderToMinimum); return;
+        case Qt::Key_End:
+            // the end is known only once everything is indexed
+            indexUntil(m_text.size());
+            verticalScrollBar()->triggerAction(QAbstractSlider::SliderToMaximum);
+            return;
+    }
+
+    QAbstractScrollArea::keyPressEvent(event);
+}
@@ -0,0 +1,95 @@
+#pragma once
+
+#include <QAbstractScrollArea>
+#include <QByteArray>
+#include <QColor>
+#include <QTimer>
+
+#include <string_view>
+#include <vector>
+
+// Read-only view of a large utf-8 text. Lines are indexed in steps while the view
+// is idle, and only the visible lines are decoded and drawn, so the text is never
+// copied. Long lines are wrapped at a fixed number of bytes.
+// Ctrl+F asks for a string to find, F3 and Shift+F3 move between matches.
+// JSON highlighting tokenizes only the painted lines, the indexer records whether
+// each line starts inside a string.
+class LargeTextView : public QAbstractScrollArea
+{
+    Q_OBJECT
+
+public:
+    explicit LargeTextView(QWidget* parent = nullptr);
+
+    // the bytes must outlive the view, e.g. QByteArray::fromRawData over a document
+    void setText(const QByteArray& text);
+    bool find(const QString& query, bool forward = true);
+    // marks a range like a match and scrolls to it
+    void showRange(qsizetype offset, qsizetype length);
+
+    // takes effect with the next setText
+    void setHighlighting(bool enabled) { m_highlighting = enabled; }
+
+    int lineCount() const { return static_cast<int>(m_lines.size()); }
+    bool isIndexed() const { return m_indexed >= m_text.size(); }
+
+signals:
+    void matchNotFound(const QString& query);
+
+protected:
+    void paintEvent(QPaintEvent* event) override;
+    void resizeEvent(QResizeEvent* event) override;
+    void keyPressEvent(QKeyEvent* event) override;
+
+private:
+    static constexpr qsizetype WRAP_BYTES = 256;
+    static constexpr qsizetype INDEX_STEP = 4 * 1024 * 1024;
+
+    enum class Token : uint8_t
+    {
+        Plain,
+        Key,
+        String,
+        Number,
+        Literal,
+        Punctuation,
+    };
+
+    // tokenizer state at the start of a line
+    enum State : uint8_t
+    {
+        InString = 1,
+        Escaped = 2,
+    };
+
+    struct Run
+    {
+        qsizetype length;
+        Token token;
+    };
+
+    QByteArray m_text;
+    std::vector<qsizetype> m_lines; // start of every indexed line
+    qsizetype m_indexed = 0;        // start of the next line to index
+    QTimer m_indexer;
+
+    bool m_highlighting = false;
+    std::vector<uint8_t> m_states;  // State of every indexed line when highlighting
+    uint8_t m_state = 0;            // state at m_indexed
+
+    QString m_query;
+    qsizetype m_matchOffset = -1;
+    qsizetype m_matchLength = 0;
+
+    void indexStep(qsizetype budget);
+    void indexUntil(qsizetype offset);
+    int lineOf(qsizetype offset) const;
+    std::string_view line(int index) const;
+    int visibleLines() const;
+    void updateScrollBars();
+    void scrollToMatch();
+
+    static uint8_t advance(std::string_view bytes, uint8_t state);
+    static void tokenize(std::string_view bytes, uint8_t state, std::vector<Run>& runs);
+    QColor color(Token token) const;
+};
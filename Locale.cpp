@@ -1,3 +1,4 @@
 #include "Locale.h"
 
 QLocale locale;
+NumberFormatter numberFormatter(locale); // after `locale`, same translation unit
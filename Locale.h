@@ -1,3 +1,8 @@
+#pragma once
+
 #include <QLocale>
 
+#include "NumberFormatter.h"
+
 extern QLocale locale;
+extern NumberFormatter numberFormatter; // numbers in `locale` for table and tree cells
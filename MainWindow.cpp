@@ -1,21 +1,32 @@
 #include "MainWindow.h"
 #include "JsonCellEditorDelegate.h"
-#include "treeViewUtil.h"
-#include "WheelSignalEmitter.h"
 #include "HoverEditorHandler.h"
+#include "RecordExporter.h"
+#include "TableSizer.h"
+#include "DiagnosticsDialog.h"
+#include "Locale.h"
 
 #include <QFileDialog>
+#include <QFile>
 #include <QStatusBar>
 #include <QToolBar>
 #include <QMenuBar>
 #include <QMessageBox>
 #include <QDir>
-#include <QListView>
 #include <QScrollBar>
 #include <QShortcut>
 #include <QVBoxLayout>
 #include <QApplication>
 #include <QClipboard>
+#include <QHeaderView>
+#include <QInputDialog>
+#include <QMenu>
+#include <QProgressDialog>
+#include <QFutureWatcher>
+#include <QtConcurrent/QtConcurrent>
+
+#include <algorithm>
+#include <numeric>
 
 MainWindow::MainWindow(QWidget* parent)
     : QMainWindow(parent) {
@@ -27,9 +38,15 @@ MainWindow::MainWindow(QWidget* parent)
 void MainWindow::setupUI() {
     auto* mainSplitter = new QSplitter(Qt::Horizontal);
 
-    auto* tabWidget = new QTabWidget;
-    tabWidget->addTab(new QListView, "Tab 1");
-    tabWidget->addTab(new QListView, "Tab 2");
+    sideTabs = new QTabWidget;
+    statisticsPanel = new StatisticsPanel(&jsonFile);
+    sideTabs->addTab(statisticsPanel, "Statistics");
+    groupByPanel = new GroupByPanel(&jsonFile);
+    sideTabs->addTab(groupByPanel, "Group by");
+    rawView = new RawRecordView(&jsonFile);
+    sideTabs->addTab(rawView, "Raw");
+    errorPanel = new ErrorPanel(&jsonFile);
+    sideTabs->addTab(errorPanel, "Errors");
 
     tableView = new QTableView;
     treeView = new QTreeView;
@@ -54,7 +71,7 @@ void MainWindow::setupUI() {
     rightSplitter->addWidget(tableWidget);
     rightSplitter->addWidget(treeWidget);
 
-    mainSplitter->addWidget(tabWidget);
+    mainSplitter->addWidget(sideTabs);
     mainSplitter->addWidget(rightSplitter);
     mainSplitter->setStretchFactor(1, 1);
 
@@ -67,7 +84,8 @@ void MainWindow::setupUI() {
     tableModel = new JsonTableModel(&jsonFile, this);
     tableView->setModel(tableModel);
     tableView->setSelectionBehavior(QAbstractItemView::SelectRows);
-    tableView->setSelectionMode(QAbstractItemView::SingleSelection);
+    tableView->setSelectionMode(QAbstractItemView::ExtendedSelection);
+    new TableSizer(tableView, this);
 
     // setup tree view
     treeView->setUniformRowHeights(false);
@@ -80,6 +98,24 @@ void MainWindow::setupUI() {
 
     setCentralWidget(mainSplitter);
 
+    treeLoader = new TreeModelLoader(&jsonFile, treeView, this);
+
+    // every cache holding parsed or formatted data stays within one budget
+    memoryGovernor = new MemoryGovernor(this);
+    memoryGovernor->add("documents",
+        [this]() { return jsonFile.parsedBytes(); },
+        [this](size_t target) { jsonFile.evictParsed(target); });
+    // the slot array of the cell cache is fixed, only its values can shrink
+    memoryGovernor->add("cells",
+        [this]() { return tableModel->cellCache().valueBytes(); },
+        [this](size_t target) { tableModel->trimCache(target); });
+    memoryGovernor->add("trees",
+        [this]() { return treeLoader->memoryUsage(); },
+        [this](size_t target) { treeLoader->trim(target); });
+    connect(memoryGovernor, &MemoryGovernor::pressure, this, [this]() {
+        statusBar()->showMessage("Low on memory, caches were trimmed", 3000);
+    });
+
     fileWatcher = new QFileSystemWatcher(this);
     statusBar()->showMessage("Ready");
 }
@@ -87,18 +123,28 @@ void MainWindow::setupUI() {
 void MainWindow::setupMenu() {
     QMenu* fileMenu = menuBar()->addMenu("&File");
     QAction* openAction = fileMenu->addAction("&Open");
+    QAction* exportSelectedAction = fileMenu->addAction("Export &selected records...");
+    QAction* exportAllAction = fileMenu->addAction("Export &all records...");
     QAction* exitAction = fileMenu->addAction("E&xit");
 
     QMenu* editMenu = menuBar()->addMenu("&Edit");
     QAction* refreshAction = editMenu->addAction("&Refresh");
+    QAction* addColumnAction = editMenu->addAction("Add &path column...");
+
+    QMenu* helpMenu = menuBar()->addMenu("&Help");
+    QAction* diagnosticsAction = helpMenu->addAction("&Diagnostics...");
 
     QToolBar* toolbar = addToolBar("Main Toolbar");
     toolbar->addAction(openAction);
     toolbar->addAction(refreshAction);
 
     connect(openAction, &QAction::triggered, this, &MainWindow::onOpenFile);
+    connect(exportSelectedAction, &QAction::triggered, this, [this]() { exportRecords(true); });
+    connect(exportAllAction, &QAction::triggered, this, [this]() { exportRecords(false); });
     connect(refreshAction, &QAction::triggered, this, &MainWindow::onRefresh);
+    connect(addColumnAction, &QAction::triggered, this, &MainWindow::onAddPathColumn);
     connect(exitAction, &QAction::triggered, this, &QWidget::close);
+    connect(diagnosticsAction, &QAction::triggered, this, &MainWindow::showDiagnostics);
     connect(treeView, &QTreeView::clicked, this, &MainWindow::openEditor);
 }
 
@@ -115,23 +161,31 @@ void MainWindow::setupConnections() {
     // });
     // ---
 
-#if 0
-    connect(treeView, &QTreeView::clicked, this, &MainWindow::openEditorsForVisibleRows);
-    connect(treeView->verticalScrollBar(), &QScrollBar::valueChanged, this, &MainWindow::openEditorsForVisibleRows);
-    connect(treeView, &QTreeView::expanded, this, &MainWindow::openEditorsForVisibleRows);
-    connect(treeView, &QTreeView::collapsed, this, &MainWindow::openEditorsForVisibleRows);
-
-    auto* wheelEmitter = new WheelSignalEmitter();
-    treeView->viewport()->installEventFilter(wheelEmitter);
-
-    connect(wheelEmitter, &WheelSignalEmitter::wheelScrolled, this, &MainWindow::openEditorsForVisibleRows);
-#else
-
     // make text editable on hover
     treeView->viewport()->setMouseTracking(true);
     auto* hoverHandler = new HoverEditorHandler(treeView, treeView);
     treeView->viewport()->installEventFilter(hoverHandler);
-#endif
+
+    // column actions in the table header
+    tableView->horizontalHeader()->setContextMenuPolicy(Qt::CustomContextMenu);
+    connect(tableView->horizontalHeader(), &QHeaderView::customContextMenuRequested, this, [this](const QPoint& pos) {
+        int section = tableView->horizontalHeader()->logicalIndexAt(pos);
+        auto path = tableModel->columnPath(section);
+        if (!path)
+            return;
+
+        QMenu menu(this);
+        menu.addAction("Column statistics", [this, path]() {
+            statisticsPanel->compute(*path);
+        });
+
+        if (tableModel->isPathColumn(section)) {
+            menu.addAction("Remove column", [this, section]() {
+                tableModel->removePathColumn(section);
+            });
+        }
+        menu.exec(tableView->horizontalHeader()->mapToGlobal(pos));
+    });
 
     // context menu in tree view
     treeView->setContextMenuPolicy(Qt::CustomContextMenu);
@@ -182,6 +236,31 @@ void MainWindow::setupConnections() {
     });
 
     connect(fileWatcher, &QFileSystemWatcher::fileChanged, this, &MainWindow::onFileChanged);
+
+    connect(groupByPanel, &GroupByPanel::rowRequested, this, [this](int row) {
+        QModelIndex index = tableModel->index(row, 0);
+        tableView->scrollTo(index, QAbstractItemView::PositionAtCenter);
+        tableView->setCurrentIndex(index);
+        tableView->selectionModel()->select(index, QItemSelectionModel::ClearAndSelect | QItemSelectionModel::Rows);
+    });
+
+    connect(errorPanel, &ErrorPanel::errorsChanged, this, [this](int count) {
+        sideTabs->setTabText(sideTabs->indexOf(errorPanel), count ? QString("Errors (%1)").arg(count) : QString("Errors"));
+    });
+
+    connect(errorPanel, &ErrorPanel::jumpRequested, this, [this](qulonglong offset, qulonglong length, qulonglong record) {
+        if (jsonFile.size() == 0)
+            return;
+        // skipped bytes belong to no record, show the one following them
+        int row = static_cast<int>(std::min(record < jsonFile.size() ? record : jsonFile.recordAt(offset), jsonFile.size() - 1));
+        QModelIndex index = tableModel->index(row, 0);
+        tableView->scrollTo(index, QAbstractItemView::PositionAtCenter);
+        tableView->setCurrentIndex(index);
+        tableView->selectionModel()->select(index, QItemSelectionModel::ClearAndSelect | QItemSelectionModel::Rows);
+
+        rawView->showOffset(row, offset, length);
+        sideTabs->setCurrentWidget(rawView);
+    });
 }
 
 void MainWindow::onOpenFile() {
@@ -189,7 +268,7 @@ void MainWindow::onOpenFile() {
         this,
         "Open JSONL File",
         QDir::currentPath(),
-        "Json Files (*.json *.jsonl);;All Files (*)"
+        "Json Files (*.json *.jsonl *.ndjson *.json-seq);;All Files (*)"
     );
     if (!path.isEmpty()) {
         loadJson(path);
@@ -204,30 +283,139 @@ void MainWindow::onRefresh() {
     // statusBar()->showMessage("Refreshed", 2000);
 }
 
-JsonTreeModel * MainWindow::getTreeModel()
+void MainWindow::stopBackgroundWork()
 {
-    return dynamic_cast<JsonTreeModel *>(treeView->model());
+    // everything here reads the mapped file
+    tableModel->cancelParsing();
+    treeLoader->clear();
+    statisticsPanel->cancel();
+    groupByPanel->cancel();
+    errorPanel->cancel();
+    rawView->clear();
+
+    if (exportFuture.isRunning()) {
+        exportFuture.cancel();
+        exportFuture.waitForFinished();
+    }
+
+    // raw copies read the mapping, values themselves are kept by their exporter
+    for (auto& job : valueJobs) {
+        job.cancel();
+        job.waitForFinished();
+    }
+    valueJobs.clear();
 }
 
-void MainWindow::onTableRowSelected(const QModelIndex& current, const QModelIndex&) {
-    if (!current.isValid())
+void MainWindow::exportRecords(bool selectedOnly)
+{
+    if (exportFuture.isRunning()) {
+        statusBar()->showMessage("Export is already running", 2000);
+        return;
+    }
+
+    std::vector<size_t> rows;
+    if (selectedOnly) {
+        // selection ranges avoid building an index per selected cell
+        for (const auto& range : tableView->selectionModel()->selection()) {
+            for (int row = range.top(); row <= range.bottom(); ++row)
+                rows.push_back(row);
+        }
+        std::sort(rows.begin(), rows.end());
+        rows.erase(std::unique(rows.begin(), rows.end()), rows.end());
+    } else {
+        rows.resize(jsonFile.size());
+        std::iota(rows.begin(), rows.end(), size_t(0));
+    }
+
+    if (rows.empty()) {
+        statusBar()->showMessage("No records to export", 2000);
         return;
+    }
 
-    int row = current.row();
-    const JsonFile::LineInfo& line = jsonFile.line(row);
-    const rapidjson::Value& val = line.doc;
+    const QStringList formats = {"Raw (as in the file)", "Minified", "Pretty-printed"};
+    bool ok = false;
+    QString format = QInputDialog::getItem(this, "Export records", "Format:", formats, 0, false, &ok);
+    if (!ok)
+        return;
 
-    auto* model = new JsonTreeModel(&val, treeView);
-    auto currentModel = treeView->model();
+    QString path = QFileDialog::getSaveFileName(this, "Export records", QDir::currentPath(), "JSON Lines (*.jsonl);;All Files (*)");
+    if (path.isEmpty())
+        return;
 
-    treeView->setModel(model);
-    treeView->expand(QModelIndex());
+    auto exportFormat = static_cast<RecordExporter::Format>(formats.indexOf(format));
+    const size_t total = rows.size();
+    const JsonFile* file = &jsonFile;
 
-    connect(treeView->model(), &QAbstractItemModel::rowsInserted, this, &MainWindow::openEditorsForVisibleRows);
+    exportFuture = QtConcurrent::run([file, rows = std::move(rows), path, exportFormat, total](QPromise<QString>& promise) {
+        promise.setProgressRange(0, 1000);
+
+        QString error;
+        RecordExporter exporter(file, exportFormat);
+        bool ok = exporter.write(rows, path, [&](size_t done) {
+            promise.setProgressValue(static_cast<int>(done * 1000 / total));
+            return !promise.isCanceled();
+        }, &error);
+
+        promise.addResult(ok ? QString() : error);
+    });
+
+    auto* progress = new QProgressDialog(QString("Exporting %1 records...").arg(locale.toString(qulonglong(total))), "Cancel", 0, 1000, this);
+    progress->setWindowModality(Qt::WindowModal);
+    progress->setMinimumDuration(500);
+
+    auto* watcher = new QFutureWatcher<QString>(this);
+    connect(watcher, &QFutureWatcher<QString>::progressValueChanged, progress, &QProgressDialog::setValue);
+    connect(progress, &QProgressDialog::canceled, watcher, &QFutureWatcher<QString>::cancel);
+    connect(watcher, &QFutureWatcher<QString>::finished, this, [this, watcher, progress, path, total]() {
+        progress->deleteLater();
+        watcher->deleteLater();
+
+        // a canceled promise drops its result, and the exporter removed the file
+        if (watcher->future().isCanceled()) {
+            statusBar()->showMessage("Export canceled", 5000);
+            return;
+        }
+
+        QString error = watcher->future().resultCount() ? watcher->future().result() : QString("Canceled");
+        if (error.isEmpty())
+            statusBar()->showMessage(QString("Exported %1 records to %2").arg(locale.toString(qulonglong(total)), path), 5000);
+        else
+            QMessageBox::warning(this, "Export failed", error);
+    });
+    watcher->setFuture(exportFuture);
+}
+
+void MainWindow::showDiagnostics()
+{
+    auto* dialog = new DiagnosticsDialog(&jsonFile, tableModel, memoryGovernor, this);
+    dialog->setAttribute(Qt::WA_DeleteOnClose);
+    dialog->show();
+}
+
+void MainWindow::onAddPathColumn() {
+    bool ok = false;
+    QString path = QInputDialog::getText(this, "Add path column",
+        "JSON path, e.g. request.headers.user-agent or items[0].id:", QLineEdit::Normal, QString(), &ok);
+    if (!ok || path.isEmpty())
+        return;
+
+    QString error;
+    if (!tableModel->addPathColumn(path, &error))
+        QMessageBox::warning(this, "Error", QString("Invalid path '%1': %2").arg(path, error));
+}
+
+JsonTreeModel * MainWindow::getTreeModel()
+{
+    return dynamic_cast<JsonTreeModel *>(treeView->model());
+}
 
-    // openEditorsRecursive(treeView);
+void MainWindow::onTableRowSelected(const QModelIndex& current, const QModelIndex&) {
+    if (!current.isValid())
+        return;
 
-    delete currentModel;
+    // the tree is built in background, see TreeModelLoader
+    treeLoader->request(current.row());
+    rawView->showRecord(current.row());
 }
 
 void MainWindow::onFileChanged(const QString& path) {
@@ -241,10 +429,11 @@ void MainWindow::onFileChanged(const QString& path) {
     if (treeView && treeView->selectionModel())
         treeIndex = treeView->selectionModel()->currentIndex();
 
+    stopBackgroundWork(); // Clear the tree view model
     jsonFile.close();
     jsonFile.open(path);
     tableModel->reload();
-    treeView->setModel(nullptr); // Clear the tree view model
+    errorPanel->scan();
 
     // restore table state
     if (tableIndex.isValid() && tableView->model()) {
@@ -263,6 +452,8 @@ void MainWindow::onFileChanged(const QString& path) {
 void MainWindow::loadJson(const QString& filePath)
 {
     setCursor(Qt::WaitCursor);
+    stopBackgroundWork();
+    jsonFile.close();
     auto status = jsonFile.open(filePath);
     unsetCursor();
     tableModel->reload();
@@ -270,12 +461,13 @@ void MainWindow::loadJson(const QString& filePath)
         QMessageBox::critical(this, "Error", "Failed to open file.");
         return;
     }
+    errorPanel->scan();
 
     // remove all
     fileWatcher->removePaths(fileWatcher->files());
     // ... add new
     fileWatcher->addPath(filePath);
-    statusBar()->showMessage("Loaded " + filePath, 2000);
+    statusBar()->showMessage(QString("Loaded %1 (%2)").arg(filePath, formatName(jsonFile.format())), 2000);
 }
 
 void MainWindow::openEditor(const QModelIndex& index)
@@ -299,95 +491,140 @@ void MainWindow::processArguments(const QStringList& args) {
     }
 }
 
-#if 0
-void MainWindow::openEditorsForVisibleRows() {
-    auto* model = treeView->model();
-    auto* viewport = treeView->viewport();
-    QRect visibleRect = viewport->rect();
-
-    for (int row = 0; row < model->rowCount(); ++row) {
-        QModelIndex index = model->index(row, TreeViewColumn::ValueColumn);
-        QRect indexRect = treeView->visualRect(index);
-        if (visibleRect.intersects(indexRect)) {
-            JsonTreeItem* item = JsonTreeItem::fromIndex(index);
-            if (item->isMultiline()) {
-                treeView->openPersistentEditor(index);
-            }
-        }
+void MainWindow::onTreeContextMenuRequested(const QPoint& pos)
+{
+    QModelIndex index = treeView->indexAt(pos);
+    if (!index.isValid())
+        return;
 
-        // Recursively handle children if expanded
-        QModelIndex child = model->index(row, 0);
-        if (treeView->isExpanded(child)) {
-            openEditorsForVisibleChildren(child);
-        }
-    }
-}
+    // the tree may be replaced while the menu is open
+    QPersistentModelIndex item(index);
 
-void MainWindow::openEditorsForVisibleChildren(const QModelIndex& parent) {
-    auto* model = treeView->model();
-    for (int row = 0; row < model->rowCount(parent); ++row) {
-        QModelIndex index = model->index(row, TreeViewColumn::ValueColumn, parent);
-        QRect indexRect = treeView->visualRect(index);
-        if (treeView->viewport()->rect().intersects(indexRect)) {
-            JsonTreeItem* item = JsonTreeItem::fromIndex(index);
-            if (item->isMultiline()) {
-                treeView->openPersistentEditor(index);
-            }
-        }
+    QMenu menu(this);
+    menu.addAction("Copy value to clipboard", [=]() {
+        copyValue(item, ValueExporter::Format::Minified);
+    });
 
-        QModelIndex child = model->index(row, 0, parent);
-        if (treeView->isExpanded(child)) {
-            openEditorsForVisibleChildren(child);
-        }
-    }
-}
+    menu.addAction("Copy pretty value to clipboard", [=]() {
+        copyValue(item, ValueExporter::Format::Pretty);
+    });
 
-#else
+    menu.addAction("Copy source to clipboard", [=]() {
+        copyValue(item, ValueExporter::Format::Raw);
+    });
 
-void MainWindow::openEditorsForVisibleRows()
-{
-    QTreeView* view = treeView;
-    if (!view || !view->model()) return;
+    menu.addSeparator();
+    menu.addAction("Save value as...", [=]() {
+        saveValue(item);
+    });
 
-    const QRect visibleRect = view->viewport()->rect();
-    const int rowHeight = view->sizeHintForRow(0);
-    const int step = qMax(1, rowHeight / 2);
+    menu.exec(treeView->viewport()->mapToGlobal(pos));
+}
 
-    QSet<QModelIndex> seen;
+std::optional<ValueExporter> MainWindow::largeValue(const QModelIndex& index) const
+{
+    auto* model = qobject_cast<const JsonTreeModel*>(index.model());
+    JsonTreeItem* item = JsonTreeItem::fromIndex(index);
 
-    for (int y = visibleRect.top(); y < visibleRect.bottom(); y += step) {
-        QModelIndex index = view->indexAt(QPoint(0, y));
-        if (!index.isValid()) continue;
+    // values of lazy models are dropped with the model, their source in the mapped file stays
+    if (model && model->isLazy()) {
+        const auto source = item->rawSource();
+        if (source.empty() || (!item->isLazy() && source.size() < ASYNC_COPY_THRESHOLD))
+            return std::nullopt;
+        return ValueExporter(nullptr, nullptr, source);
+    }
 
-        QModelIndex valueIndex = index.sibling(index.row(), TreeViewColumn::ValueColumn);
-        if (seen.contains(valueIndex)) continue;
-        seen.insert(valueIndex);
+    const rapidjson::Value* value = item->value();
+    if (!model || !model->document() || !value)
+        return std::nullopt;
+    if (!value->IsString() && !value->IsObject() && !value->IsArray())
+        return std::nullopt;
+
+    // a container without source can't be measured cheaply, treat it as large
+    ValueExporter exporter(model->document(), value, item->rawSource());
+    const bool measured = value->IsString() || !item->rawSource().empty();
+    if (measured && exporter.sizeHint() < ASYNC_COPY_THRESHOLD)
+        return std::nullopt;
+    return exporter;
+}
 
-        JsonTreeItem* item = JsonTreeItem::fromIndex(valueIndex);
+void MainWindow::copyValue(const QModelIndex& index, ValueExporter::Format format)
+{
+    if (!index.isValid())
+        return;
 
-        if (item->isMultiline()) {
-            view->openPersistentEditor(valueIndex);
-        }
+    auto exporter = largeValue(index);
+    if (!exporter) {
+        JsonTreeItem* item = JsonTreeItem::fromIndex(index);
+        if (format == ValueExporter::Format::Raw)
+            QApplication::clipboard()->setText(item->getRawText());
+        else
+            QApplication::clipboard()->setText(item->getText(format == ValueExporter::Format::Pretty));
+        return;
     }
+
+    // the clipboard takes the bytes once they're ready, nothing is copied before
+    QFuture<QByteArray> future = QtConcurrent::run([exporter = *exporter, format](QPromise<QByteArray>& promise) {
+        promise.addResult(exporter.toBytes(format, [&promise]() { return !promise.isCanceled(); }));
+    });
+    valueJobs.removeIf([](const QFuture<void>& job) { return job.isFinished(); });
+    valueJobs.append(future);
+
+    QApplication::clipboard()->setMimeData(new FutureMimeData(future));
+    statusBar()->showMessage(QString("Copying %1 bytes...").arg(locale.toString(qulonglong(exporter->sizeHint()))), 2000);
 }
-#endif
 
-void MainWindow::onTreeContextMenuRequested(const QPoint& pos)
+void MainWindow::saveValue(const QPersistentModelIndex& index)
 {
-    QModelIndex index = treeView->indexAt(pos);
-    if (!index.isValid())
+    QString path = QFileDialog::getSaveFileName(this, "Save value", QDir::currentPath(), "JSON (*.json);;All Files (*)");
+    // the tree may have been replaced in the meantime
+    if (path.isEmpty() || !index.isValid())
         return;
 
+    // the value is read from the mapping of that file
+    if (jsonFile.isOpenFile(path)) {
+        QMessageBox::warning(this, "Save failed", QString("%1 is the open file").arg(path));
+        return;
+    }
+
+    // containers as they are in the file, strings as their text
     JsonTreeItem* item = JsonTreeItem::fromIndex(index);
+    auto exporter = largeValue(index);
+    if (!exporter) {
+        const rapidjson::Value* value = item->value();
+        QByteArray bytes = (value && value->IsString() ? item->getText(false) : item->getRawText()).toUtf8();
+        QFile file(path);
+        if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate) || file.write(bytes) != bytes.size())
+            QMessageBox::warning(this, "Save failed", QString("%1: %2").arg(path, file.errorString()));
+        else
+            statusBar()->showMessage(QString("Saved value to %1").arg(path), 5000);
+        return;
+    }
 
-    QMenu menu(this);
-    menu.addAction("Copy value to clipboard", [=]() {
-        QApplication::clipboard()->setText(item->getText(false));
+    auto format = item->value() && item->value()->IsString() ? ValueExporter::Format::Minified : ValueExporter::Format::Raw;
+    QFuture<QString> future = QtConcurrent::run([exporter = *exporter, path, format](QPromise<QString>& promise) {
+        QString error;
+        bool ok = exporter.save(path, format, [&promise]() { return !promise.isCanceled(); }, &error);
+        promise.addResult(ok ? QString() : error);
     });
+    valueJobs.removeIf([](const QFuture<void>& job) { return job.isFinished(); });
+    valueJobs.append(future);
 
-    menu.addAction("Copy pretty value to clipboard", [=]() {
-        QApplication::clipboard()->setText(item->getText(true));
-    });
+    auto* watcher = new QFutureWatcher<QString>(this);
+    connect(watcher, &QFutureWatcher<QString>::finished, this, [this, watcher, path]() {
+        watcher->deleteLater();
 
-    menu.exec(treeView->viewport()->mapToGlobal(pos));
+        if (watcher->future().isCanceled()) {
+            statusBar()->showMessage("Saving the value was canceled", 5000);
+            return;
+        }
+
+        QString error = watcher->future().resultCount() ? watcher->future().result() : QString("Canceled");
+        if (error.isEmpty())
+            statusBar()->showMessage(QString("Saved value to %1").arg(path), 5000);
+        else
+            QMessageBox::warning(this, "Save failed", error);
+    });
+    watcher->setFuture(future);
+    statusBar()->showMessage(QString("Saving value to %1...").arg(path));
 }
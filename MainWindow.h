@@ -7,11 +7,19 @@
 #include <QTabWidget>
 #include <QAction>
 #include <QFileSystemWatcher>
+#include <QFuture>
 
 #include "JsonFile.h"
 #include "JsonTableModel.h"
 #include "JsonTreeModel.h"
 #include "SearchBarWidget.h"
+#include "TreeModelLoader.h"
+#include "StatisticsPanel.h"
+#include "GroupByPanel.h"
+#include "ErrorPanel.h"
+#include "MemoryGovernor.h"
+#include "ValueExporter.h"
+#include "RawRecordView.h"
 
 class MainWindow : public QMainWindow {
     Q_OBJECT
@@ -19,10 +27,14 @@ class MainWindow : public QMainWindow {
 public:
     MainWindow(QWidget* parent = nullptr);
     void processArguments(const QStringList& args);
+    void setTreeBucketSize(size_t bucketSize) { treeLoader->setBucketSize(bucketSize); }
+    // bytes for all caches, 0 picks a share of the available memory
+    void setMemoryBudget(size_t budget) { memoryGovernor->setBudget(budget); }
 
 private slots:
     void onOpenFile();
     void onRefresh();
+    void onAddPathColumn();
     void onTableRowSelected(const QModelIndex& current, const QModelIndex&);
 
 private:
@@ -33,6 +45,15 @@ private:
     SearchBarWidget* tableSearchBar = nullptr;
     SearchBarWidget* treeSearchBar = nullptr;
     QFileSystemWatcher* fileWatcher = nullptr;
+    TreeModelLoader* treeLoader = nullptr;
+    StatisticsPanel* statisticsPanel = nullptr;
+    GroupByPanel* groupByPanel = nullptr;
+    RawRecordView* rawView = nullptr;
+    ErrorPanel* errorPanel = nullptr;
+    QTabWidget* sideTabs = nullptr;
+    MemoryGovernor* memoryGovernor = nullptr;
+    QFuture<QString> exportFuture;
+    QList<QFuture<void>> valueJobs; // copies and saves of tree values
 
     void setupUI();
     void setupMenu();
@@ -41,9 +62,14 @@ private:
     void onFileChanged(const QString& path);
 
     void loadJson(const QString& filePath);
-    void openEditorsForVisibleRows();
+    void stopBackgroundWork();
+    void exportRecords(bool selectedOnly);
+    void showDiagnostics();
+    void copyValue(const QModelIndex& index, ValueExporter::Format format);
+    void saveValue(const QPersistentModelIndex& index);
+    // exporter for a value that outlives its tree model, none for small or scalar values
+    std::optional<ValueExporter> largeValue(const QModelIndex& index) const;
     JsonTreeModel * getTreeModel();
 
     void onTreeContextMenuRequested(const QPoint& pos);
-    // void openEditorsForVisibleChildren(const QModelIndex& parent);
 };
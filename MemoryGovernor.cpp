@@ -0,0 +1,209 @@
+#include "MemoryGovernor.h"
+#include "constants.h"
+
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QStringList>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstring>
+#include <limits>
+
+namespace
+{
+    // a PSI trigger fires when tasks stall on memory for 150ms within 2s,
+    // windows of whole seconds are what unprivileged processes may use
+    const char PSI_TRIGGER[] = "some 150000 2000000";
+
+    // cgroup v2 directory of the process, from the "0::/path" line
+    QString findCgroup()
+    {
+        QFile file("/proc/self/cgroup");
+        if (!file.open(QIODevice::ReadOnly))
+            return QString();
+
+        for (const QByteArray& line : file.readAll().split('\n')) {
+            if (line.startsWith("0::")) {
+                QString path = "/sys/fs/cgroup" + QString::fromUtf8(line.mid(3));
+                return QDir(path).exists() ? QDir::cleanPath(path) : QString();
+            }
+        }
+        return QString();
+    }
+
+    // memory.high or memory.max, "max" means no limit
+    size_t readCgroupLimit(const QString& path)
+    {
+        QFile file(path);
+        if (!file.open(QIODevice::ReadOnly))
+            return std::numeric_limits<size_t>::max();
+
+        bool ok = false;
+        size_t value = file.readAll().trimmed().toULongLong(&ok);
+        return ok ? value : std::numeric_limits<size_t>::max();
+    }
+}
+
+MemoryGovernor::MemoryGovernor(QObject* parent)
+    : QObject(parent)
+    , m_cgroup(findCgroup())
+{
+    m_limit = detectLimit();
+    setBudget(0);
+
+    connect(&m_timer, &QTimer::timeout, this, &MemoryGovernor::enforce);
+    m_timer.start(MEMORY_CHECK_INTERVAL_MS);
+
+    watchPressure();
+}
+
+MemoryGovernor::~MemoryGovernor()
+{
+    delete m_psiNotifier;
+    delete m_eventsNotifier;
+    if (m_psiFile >= 0)
+        ::close(m_psiFile);
+    if (m_eventsFile >= 0)
+        ::close(m_eventsFile);
+}
+
+size_t MemoryGovernor::detectLimit() const
+{
+    size_t limit = static_cast<size_t>(sysconf(_SC_PHYS_PAGES)) * static_cast<size_t>(sysconf(_SC_PAGESIZE));
+
+    // limits of parent cgroups apply as well
+    QString path = m_cgroup;
+    while (path.startsWith("/sys/fs/cgroup/")) {
+        limit = std::min({limit, readCgroupLimit(path + "/memory.high"), readCgroupLimit(path + "/memory.max")});
+        path = QFileInfo(path).path();
+    }
+    return limit;
+}
+
+void MemoryGovernor::add(const QString& name, SizeFunction size, ShrinkFunction shrink)
+{
+    m_consumers.push_back(Consumer{name, std::move(size), std::move(shrink)});
+}
+
+void MemoryGovernor::setBudget(size_t budget)
+{
+    // a budget above the limit would only end in the OOM killer
+    const size_t available = static_cast<size_t>(m_limit * MEMORY_BUDGET_SHARE);
+    m_budget = budget ? std::min(budget, available) : available;
+    enforce();
+}
+
+size_t MemoryGovernor::usage() const
+{
+    size_t total = 0;
+    for (const auto& consumer : m_consumers)
+        total += consumer.size();
+    return total;
+}
+
+void MemoryGovernor::enforce()
+{
+    if (usage() > m_budget)
+        shrinkTo(static_cast<size_t>(m_budget * MEMORY_LOW_WATERMARK));
+}
+
+void MemoryGovernor::shrinkTo(size_t target)
+{
+    std::vector<size_t> sizes;
+    size_t total = 0;
+    for (const auto& consumer : m_consumers) {
+        sizes.push_back(consumer.size());
+        total += sizes.back();
+    }
+    if (total <= target)
+        return;
+
+    // every cache gives up the same share of what it holds
+    const double keep = double(target) / double(total);
+    for (size_t i = 0; i < m_consumers.size(); ++i)
+        m_consumers[i].shrink(static_cast<size_t>(sizes[i] * keep));
+    ++m_shrinks;
+}
+
+void MemoryGovernor::onPressure()
+{
+    ++m_pressureEvents;
+    shrinkTo(static_cast<size_t>(usage() * MEMORY_PRESSURE_SHRINK));
+    emit pressure();
+}
+
+void MemoryGovernor::watchPressure()
+{
+    // pressure of our cgroup tells about a tight limit of a shared host, the system wide
+    // pressure is the fallback
+    QStringList candidates;
+    if (!m_cgroup.isEmpty())
+        candidates << m_cgroup + "/memory.pressure";
+    candidates << "/proc/pressure/memory";
+
+    for (const QString& path : candidates) {
+        int fd = ::open(QFile::encodeName(path).constData(), O_RDWR | O_NONBLOCK | O_CLOEXEC);
+        if (fd < 0)
+            continue;
+
+        if (::write(fd, PSI_TRIGGER, std::strlen(PSI_TRIGGER) + 1) < 0) {
+            ::close(fd); // e.g. an older kernel without unprivileged triggers
+            continue;
+        }
+
+        m_psiFile = fd;
+        m_psiNotifier = new QSocketNotifier(fd, QSocketNotifier::Exception);
+        connect(m_psiNotifier, &QSocketNotifier::activated, this, &MemoryGovernor::onPressure);
+        break;
+    }
+
+    // memory.events changes when the cgroup hits memory.high or memory.max
+    if (!m_cgroup.isEmpty()) {
+        int fd = ::open(QFile::encodeName(m_cgroup + "/memory.events").constData(), O_RDONLY | O_CLOEXEC);
+        if (fd >= 0) {
+            m_eventsFile = fd;
+            m_limitEvents = readLimitEvents();
+            m_eventsNotifier = new QSocketNotifier(fd, QSocketNotifier::Exception);
+            connect(m_eventsNotifier, &QSocketNotifier::activated, this, [this]() {
+                uint64_t events = readLimitEvents();
+                if (events > m_limitEvents)
+                    onPressure();
+                m_limitEvents = events;
+            });
+        }
+    }
+}
+
+uint64_t MemoryGovernor::readLimitEvents() const
+{
+    // reading from the start re-arms the notification
+    char buffer[512];
+    ssize_t length = ::pread(m_eventsFile, buffer, sizeof(buffer) - 1, 0);
+    if (length <= 0)
+        return m_limitEvents;
+    buffer[length] = '\0';
+
+    uint64_t events = 0;
+    for (const QByteArray& line : QByteArray(buffer, length).split('\n')) {
+        auto parts = line.split(' ');
+        if (parts.size() == 2 && (parts[0] == "high" || parts[0] == "max" || parts[0] == "oom"))
+            events += parts[1].toULongLong();
+    }
+    return events;
+}
+
+diagnostics::MemoryBreakdown MemoryGovernor::breakdown() const
+{
+    diagnostics::MemoryBreakdown result;
+    result.budget = m_budget;
+    result.limit = m_limit;
+    result.pressureEvents = m_pressureEvents;
+    result.shrinks = m_shrinks;
+    for (const auto& consumer : m_consumers)
+        result.consumers.emplace_back(consumer.name.toStdString(), consumer.size());
+    return result;
+}
@@ -0,0 +1,73 @@
+#pragma once
+
+#include "Diagnostics.h"
+
+#include <QObject>
+#include <QSocketNotifier>
+#include <QString>
+#include <QTimer>
+
+#include <functional>
+#include <vector>
+
+// Keeps all caches of the viewer within one memory budget. Caches register their
+// size and a way to shrink, the governor checks them periodically and shrinks them
+// in proportion to their size when over budget. Memory pressure reported by Linux,
+// through a PSI trigger or cgroup memory.events, shrinks them right away.
+class MemoryGovernor : public QObject
+{
+    Q_OBJECT
+
+public:
+    using SizeFunction = std::function<size_t()>;
+    using ShrinkFunction = std::function<void(size_t target)>;
+
+    explicit MemoryGovernor(QObject* parent = nullptr);
+    ~MemoryGovernor() override;
+
+    // `shrink` gets the bytes the cache should keep at most
+    void add(const QString& name, SizeFunction size, ShrinkFunction shrink);
+
+    // 0 picks a share of the physical memory or the cgroup limit, whichever is lower
+    void setBudget(size_t budget);
+    size_t budget() const { return m_budget; }
+    // memory the process may use
+    size_t limit() const { return m_limit; }
+    size_t usage() const;
+
+    // shrink the caches if they are over budget
+    void enforce();
+    diagnostics::MemoryBreakdown breakdown() const;
+
+signals:
+    // caches were shrunk because the system runs low on memory
+    void pressure();
+
+private:
+    struct Consumer
+    {
+        QString name;
+        SizeFunction size;
+        ShrinkFunction shrink;
+    };
+
+    std::vector<Consumer> m_consumers;
+    size_t m_limit = 0;
+    size_t m_budget = 0;
+    size_t m_pressureEvents = 0;
+    size_t m_shrinks = 0;
+
+    QTimer m_timer;
+    QString m_cgroup; // directory of our cgroup v2, empty when not found
+    int m_psiFile = -1;
+    int m_eventsFile = -1;
+    QSocketNotifier* m_psiNotifier = nullptr;
+    QSocketNotifier* m_eventsNotifier = nullptr;
+    uint64_t m_limitEvents = 0; // high, max and oom events of memory.events
+
+    void shrinkTo(size_t target);
+    void onPressure();
+    void watchPressure();
+    uint64_t readLimitEvents() const;
+    size_t detectLimit() const;
+};
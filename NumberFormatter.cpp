@@ -0,0 +1,215 @@
+#include "NumberFormatter.h"
+
+#include <charconv>
+#include <cmath>
+#include <cstring>
+#include <limits>
+
+NumberFormatter::NumberFormatter(const QLocale& locale)
+    : m_locale(locale)
+{
+    // to_chars only writes ASCII digits
+    if (m_locale.zeroDigit() != QString("0"))
+        return;
+
+    if (!(m_locale.numberOptions() & QLocale::OmitGroupSeparator))
+        m_group = m_locale.groupSeparator().toStdString();
+    m_decimal = m_locale.decimalPoint().toStdString();
+    m_minus = m_locale.negativeSign().toStdString();
+    m_plus = m_locale.positiveSign().toStdString();
+    m_exponent = m_locale.exponential().toStdString();
+    detectGrouping();
+
+    m_fast = selfCheck();
+}
+
+void NumberFormatter::detectGrouping()
+{
+    if (m_group.empty())
+        return;
+
+    // group sizes are not exposed by QLocale, read them from a long number
+    QString sample = m_locale.toString(qulonglong(1234567890123456789ULL));
+    QStringList groups = sample.split(QString::fromStdString(m_group));
+    if (groups.size() >= 2) {
+        m_primaryGroup = groups.back().size();
+        m_secondaryGroup = groups.size() >= 3 ? groups[groups.size() - 2].size() : m_primaryGroup;
+    }
+
+    // some locales leave short numbers alone, e.g. 1234 but 12 345
+    m_minimumDigits = 1;
+    qulonglong power = 1;
+    for (int digits = 1; digits <= 19; ++digits, power *= 10) {
+        if (m_locale.toString(power).contains(QString::fromStdString(m_group))) {
+            m_minimumDigits = digits;
+            break;
+        }
+    }
+}
+
+bool NumberFormatter::selfCheck() const
+{
+    const int64_t integers[] = {
+        0, 7, -7, 999, 1000, -1000, 12345, 123456, 1234567, -123456789,
+        std::numeric_limits<int64_t>::min(), std::numeric_limits<int64_t>::max()
+    };
+    const double doubles[] = {
+        0.0, 0.5, -1.25, 3.14159265, 1234.5, -9876.54321, 123456.0, 1234567.0,
+        1e-5, 0.0001234, 1e21, -2.5e-300, 100.0, 999999.5
+    };
+
+    Buffer buffer;
+    auto same = [&](std::string_view text, const QString& expected) {
+        return QString::fromUtf8(text.data(), text.size()) == expected;
+    };
+
+    for (int64_t value : integers) {
+        if (!same(format(value, buffer), m_locale.toString(qlonglong(value))))
+            return false;
+    }
+
+    const uint64_t largest = std::numeric_limits<uint64_t>::max();
+    if (!same(format(largest, buffer), m_locale.toString(qulonglong(largest))))
+        return false;
+
+    for (double value : doubles) {
+        if (!same(format(value, buffer), m_locale.toString(value)))
+            return false;
+    }
+    return true;
+}
+
+char* NumberFormatter::append(char* out, const std::string& text)
+{
+    std::memcpy(out, text.data(), text.size());
+    return out + text.size();
+}
+
+char* NumberFormatter::writeGrouped(char* out, const char* digits, size_t count) const
+{
+    const size_t primary = m_primaryGroup;
+    const size_t secondary = m_secondaryGroup;
+
+    if (m_group.empty() || count < size_t(m_minimumDigits) || count <= primary || secondary == 0) {
+        std::memcpy(out, digits, count);
+        return out + count;
+    }
+
+    // leading digits before the first separator, then full groups
+    const size_t grouped = count - primary;
+    size_t chunk = grouped % secondary;
+    if (chunk == 0)
+        chunk = secondary;
+
+    size_t pos = 0;
+    while (pos < grouped) {
+        std::memcpy(out, digits + pos, chunk);
+        out += chunk;
+        pos += chunk;
+        out = append(out, m_group);
+        chunk = secondary;
+    }
+
+    std::memcpy(out, digits + pos, primary);
+    return out + primary;
+}
+
+std::string_view NumberFormatter::format(uint64_t value, Buffer& buffer) const
+{
+    char digits[24];
+    auto result = std::to_chars(digits, digits + sizeof(digits), value);
+
+    char* end = writeGrouped(buffer, digits, result.ptr - digits);
+    return std::string_view(buffer, end - buffer);
+}
+
+std::string_view NumberFormatter::format(int64_t value, Buffer& buffer) const
+{
+    if (value >= 0)
+        return format(uint64_t(value), buffer);
+
+    // magnitude without overflowing on the minimum
+    uint64_t magnitude = uint64_t(-(value + 1)) + 1;
+
+    char digits[24];
+    auto result = std::to_chars(digits, digits + sizeof(digits), magnitude);
+
+    char* out = append(buffer, m_minus);
+    char* end = writeGrouped(out, digits, result.ptr - digits);
+    return std::string_view(buffer, end - buffer);
+}
+
+std::string_view NumberFormatter::format(double value, Buffer& buffer) const
+{
+    if (!std::isfinite(value))
+        return std::string_view();
+
+    // same as QLocale 'g' with precision 6
+    char text[48];
+    auto result = std::to_chars(text, text + sizeof(text), value, std::chars_format::general, 6);
+    const char* p = text;
+    const char* end = result.ptr;
+
+    char* out = buffer;
+    if (p < end && *p == '-') {
+        out = append(out, m_minus);
+        ++p;
+    }
+
+    const char* integer = p;
+    while (p < end && *p >= '0' && *p <= '9')
+        ++p;
+    out = writeGrouped(out, integer, p - integer);
+
+    if (p < end && *p == '.') {
+        out = append(out, m_decimal);
+        const char* fraction = ++p;
+        while (p < end && *p >= '0' && *p <= '9')
+            ++p;
+        std::memcpy(out, fraction, p - fraction);
+        out += p - fraction;
+    }
+
+    if (p < end && *p == 'e') {
+        out = append(out, m_exponent);
+        ++p;
+        out = append(out, *p == '-' ? m_minus : m_plus);
+        ++p;
+        std::memcpy(out, p, end - p);
+        out += end - p;
+    }
+
+    return std::string_view(buffer, out - buffer);
+}
+
+QString NumberFormatter::toString(int64_t value) const
+{
+    if (!m_fast)
+        return m_locale.toString(qlonglong(value));
+
+    Buffer buffer;
+    auto text = format(value, buffer);
+    return QString::fromUtf8(text.data(), text.size());
+}
+
+QString NumberFormatter::toString(uint64_t value) const
+{
+    if (!m_fast)
+        return m_locale.toString(qulonglong(value));
+
+    Buffer buffer;
+    auto text = format(value, buffer);
+    return QString::fromUtf8(text.data(), text.size());
+}
+
+QString NumberFormatter::toString(double value) const
+{
+    if (!m_fast)
+        return m_locale.toString(value);
+
+    Buffer buffer;
+    auto text = format(value, buffer);
+    if (text.empty())
+        return m_locale.toString(value);
+    return QString::fromUtf8(text.data(), text.size());
+}
@@ -0,0 +1,64 @@
+#pragma once
+
+#include <QLocale>
+#include <QString>
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <type_traits>
+
+// Formats numbers the way QLocale::toString does with its default precision,
+// but with std::to_chars and the symbols of the locale looked up once.
+// The output is checked against QLocale on construction, a locale that can't
+// be reproduced (e.g. non-ASCII digits) is formatted by QLocale itself.
+class NumberFormatter
+{
+public:
+    // fits any 64 bit integer or %g double even with 4 byte separators
+    static constexpr size_t BUFFER_SIZE = 160;
+    using Buffer = char[BUFFER_SIZE];
+
+    explicit NumberFormatter(const QLocale& locale = QLocale());
+
+    QString toString(int64_t value) const;
+    QString toString(uint64_t value) const;
+    QString toString(double value) const;
+
+    template <typename T, std::enable_if_t<std::is_integral_v<T> && !std::is_same_v<T, bool>, int> = 0>
+    QString toString(T value) const
+    {
+        if constexpr (std::is_signed_v<T>)
+            return toString(static_cast<int64_t>(value));
+        else
+            return toString(static_cast<uint64_t>(value));
+    }
+
+    // utf-8 text in `buffer`, valid until the buffer is reused
+    std::string_view format(int64_t value, Buffer& buffer) const;
+    std::string_view format(uint64_t value, Buffer& buffer) const;
+    // empty when the value has to go through QLocale (inf, nan)
+    std::string_view format(double value, Buffer& buffer) const;
+
+    // whether to_chars is used, false when falling back to QLocale
+    bool isFast() const { return m_fast; }
+
+private:
+    QLocale m_locale;
+    bool m_fast = false;
+
+    std::string m_group;    // empty when not grouping
+    std::string m_decimal;
+    std::string m_minus;
+    std::string m_plus;
+    std::string m_exponent;
+    int m_primaryGroup = 3;   // rightmost group
+    int m_secondaryGroup = 3; // all other groups
+    int m_minimumDigits = 1;  // shorter integer parts are not grouped
+
+    char* writeGrouped(char* out, const char* digits, size_t count) const;
+    static char* append(char* out, const std::string& text);
+
+    void detectGrouping();
+    bool selfCheck() const;
+};
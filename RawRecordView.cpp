@@ -0,0 +1,118 @@
+#include "RawRecordView.h"
+#include "constants.h"
+#include "Locale.h"
+
+#include <QFontDatabase>
+#include <QHBoxLayout>
+#include <QVBoxLayout>
+
+#include <algorithm>
+
+RawRecordView::RawRecordView(const JsonFile* jsonFile, QWidget* parent)
+    : QWidget(parent)
+    , m_jsonFile(jsonFile)
+    , m_title(new QLabel(this))
+    , m_window(new QCheckBox("Surrounding records", this))
+    , m_view(new LargeTextView(this))
+{
+    m_view->setFont(QFontDatabase::systemFont(QFontDatabase::FixedFont));
+    m_view->setHighlighting(true);
+    m_title->setTextInteractionFlags(Qt::TextSelectableByMouse);
+
+    auto* header = new QHBoxLayout;
+    header->setContentsMargins(4, 2, 4, 2);
+    header->addWidget(m_title, 1);
+    header->addWidget(m_window);
+
+    auto* layout = new QVBoxLayout(this);
+    layout->setContentsMargins(0, 0, 0, 0);
+    layout->setSpacing(2);
+    layout->addLayout(header);
+    layout->addWidget(m_view);
+
+    connect(m_window, &QCheckBox::toggled, this, &RawRecordView::refresh);
+    connect(m_view, &LargeTextView::matchNotFound, this, [this](const QString& query) {
+        m_title->setText(QString("'%1' not found").arg(query));
+    });
+}
+
+void RawRecordView::showRecord(int row)
+{
+    m_row = row;
+    m_mark.reset();
+    m_stale = true;
+    if (isVisible())
+        refresh();
+}
+
+void RawRecordView::showOffset(int row, size_t offset, size_t length)
+{
+    m_row = row;
+    m_mark = std::make_pair(offset, length);
+    m_window->setChecked(true);
+    m_stale = true;
+    if (isVisible())
+        refresh();
+}
+
+void RawRecordView::clear()
+{
+    m_row = -1;
+    m_mark.reset();
+    m_stale = false;
+    m_view->setText(QByteArray());
+    m_title->clear();
+}
+
+void RawRecordView::showEvent(QShowEvent* event)
+{
+    QWidget::showEvent(event);
+    if (m_stale)
+        refresh();
+}
+
+void RawRecordView::refresh()
+{
+    m_stale = false;
+    if (m_row < 0 || size_t(m_row) >= m_jsonFile->size()) {
+        clear();
+        return;
+    }
+
+    const auto contents = m_jsonFile->contents();
+    const size_t offset = m_jsonFile->lineOffset(m_row);
+    const size_t length = m_jsonFile->lineText(m_row).size();
+
+    m_title->setText(QString("Record %1, %2 bytes at offset %3").arg(
+        locale.toString(m_row + 1), locale.toString(qulonglong(length)), locale.toString(qulonglong(offset))));
+
+    if (!m_window->isChecked()) {
+        // the view refers to the mapping, nothing is copied
+        m_view->setText(QByteArray::fromRawData(contents.data() + offset, length));
+        return;
+    }
+
+    // whole records within RAW_WINDOW_BYTES before and after, so the text starts outside of strings
+    const size_t records = m_jsonFile->size();
+    size_t first = m_row;
+    while (first > 0 && offset - m_jsonFile->lineOffset(first - 1) <= RAW_WINDOW_BYTES)
+        --first;
+    size_t last = m_row;
+    while (last + 1 < records && m_jsonFile->lineOffset(last + 1) + m_jsonFile->lineText(last + 1).size() <= offset + length + RAW_WINDOW_BYTES)
+        ++last;
+
+    size_t start = m_jsonFile->lineOffset(first);
+    size_t end = m_jsonFile->lineOffset(last) + m_jsonFile->lineText(last).size();
+    size_t markOffset = offset;
+    size_t markLength = length;
+    if (m_mark) {
+        // skipped bytes may lie after the last record
+        markOffset = std::min(m_mark->first, contents.size());
+        markLength = std::min(m_mark->second, contents.size() - markOffset);
+        start = std::min(start, markOffset);
+        end = std::max(end, markOffset + markLength);
+        m_title->setText(QString("Offset %1, record %2").arg(locale.toString(qulonglong(markOffset)), locale.toString(m_row + 1)));
+    }
+    m_view->setText(QByteArray::fromRawData(contents.data() + start, end - start));
+    m_view->showRange(markOffset - start, markLength);
+}
@@ -0,0 +1,42 @@
+#pragma once
+
+#include "JsonFile.h"
+#include "LargeTextView.h"
+
+#include <QCheckBox>
+#include <QLabel>
+#include <QWidget>
+
+#include <optional>
+#include <utility>
+
+// Source of the selected record, or of the part of the file around it, shown
+// straight from the mapped file with JSON highlighting. Updated when visible.
+class RawRecordView : public QWidget
+{
+    Q_OBJECT
+
+public:
+    explicit RawRecordView(const JsonFile* jsonFile, QWidget* parent = nullptr);
+
+    void showRecord(int row);
+    // bytes of the file around `row`, e.g. an error found by ErrorPanel
+    void showOffset(int row, size_t offset, size_t length);
+    // drop references to the mapped file, before it is closed
+    void clear();
+
+protected:
+    void showEvent(QShowEvent* event) override;
+
+private:
+    const JsonFile* m_jsonFile;
+    QLabel* m_title;
+    QCheckBox* m_window;
+    LargeTextView* m_view;
+    int m_row = -1;
+    // marked instead of the record when set
+    std::optional<std::pair<size_t, size_t>> m_mark;
+    bool m_stale = false;
+
+    void refresh();
+};
@@ -0,0 +1,291 @@
+#include "RecordExporter.h"
+
+#include <rapidjson/document.h>
+#include <rapidjson/writer.h>
+#include <rapidjson/prettywriter.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+namespace
+{
+    const size_t IOV_BATCH = 1024;          // iovecs per writev call, within IOV_MAX
+    const size_t COPY_RUN_MIN = 64;         // adjacent records copied in kernel with copy_file_range
+    const size_t PROGRESS_STEP = 4096;
+    const size_t STREAM_BUFFER = 256 * 1024;
+
+    const char NEWLINE = '\n';
+
+    bool writeAll(int fd, iovec* iov, size_t count)
+    {
+        while (count) {
+            ssize_t written = ::writev(fd, iov, static_cast<int>(std::min(count, IOV_BATCH)));
+            if (written < 0) {
+                if (errno == EINTR)
+                    continue;
+                return false;
+            }
+
+            // skip what was written, a partial write may end inside an iovec
+            size_t n = static_cast<size_t>(written);
+            while (count && n >= iov->iov_len) {
+                n -= iov->iov_len;
+                ++iov;
+                --count;
+            }
+            if (count) {
+                iov->iov_base = static_cast<char*>(iov->iov_base) + n;
+                iov->iov_len -= n;
+            }
+        }
+        return true;
+    }
+
+    bool writeAll(int fd, const char* data, size_t size)
+    {
+        iovec iov{const_cast<char*>(data), size};
+        return writeAll(fd, &iov, 1);
+    }
+
+    // buffered output for rapidjson writers
+    class FdWriteStream
+    {
+    public:
+        typedef char Ch;
+
+        explicit FdWriteStream(int fd) : _fd(fd), _failed(false)
+        {
+            _buffer.reserve(STREAM_BUFFER);
+        }
+
+        void Put(char c)
+        {
+            _buffer.push_back(c);
+            if (_buffer.size() >= STREAM_BUFFER)
+                Flush();
+        }
+
+        void Write(std::string_view text)
+        {
+            if (_buffer.size() + text.size() >= STREAM_BUFFER)
+                Flush();
+            if (text.size() >= STREAM_BUFFER)
+                _failed |= !writeAll(_fd, text.data(), text.size());
+            else
+                _buffer.append(text);
+        }
+
+        void Flush()
+        {
+            if (!_buffer.empty())
+                _failed |= !writeAll(_fd, _buffer.data(), _buffer.size());
+            _buffer.clear();
+        }
+
+        bool failed() const { return _failed; }
+
+    private:
+        int _fd;
+        bool _failed;
+        std::string _buffer;
+    };
+
+    QString systemError(const QString& what)
+    {
+        return QString("%1: %2").arg(what, QString::fromLocal8Bit(std::strerror(errno)));
+    }
+}
+
+RecordExporter::RecordExporter(const JsonFile* jsonFile, Format format)
+    : m_jsonFile(jsonFile), m_format(format)
+{
+}
+
+bool RecordExporter::write(const std::vector<size_t>& rows, const QString& path, const Progress& progress, QString* error)
+{
+    // truncating the file being read would pull the mapping away from under us
+    if (m_jsonFile->isOpenFile(path)) {
+        if (error)
+            *error = QString("%1 is the open file").arg(path);
+        return false;
+    }
+
+    int fd = ::open(path.toLocal8Bit().constData(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0) {
+        if (error)
+            *error = systemError(path);
+        return false;
+    }
+
+    bool ok = m_format == Format::Raw
+        ? writeRaw(fd, rows, progress, error)
+        : writeFormatted(fd, rows, progress, error);
+
+    if (::close(fd) != 0 && ok) {
+        if (error)
+            *error = systemError(path);
+        ok = false;
+    }
+
+    // no partial exports are left behind
+    if (!ok)
+        ::unlink(path.toLocal8Bit().constData());
+    return ok;
+}
+
+size_t RecordExporter::runLength(const std::vector<size_t>& rows, size_t start) const
+{
+    // adjacent records separated by exactly one newline can be copied as one range
+    size_t end = start + 1;
+    while (end < rows.size() && rows[end] == rows[end - 1] + 1) {
+        auto previous = m_jsonFile->lineText(rows[end - 1]);
+        auto next = m_jsonFile->lineText(rows[end]);
+        const char* gap = previous.data() + previous.size();
+        if (next.data() != gap + 1 || *gap != NEWLINE)
+            break;
+        ++end;
+    }
+    return end - start;
+}
+
+bool RecordExporter::copyRange(int fd, size_t offset, size_t length)
+{
+#ifdef __linux__
+    // let the kernel move the bytes, falls back to writing from the mapping
+    loff_t position = static_cast<loff_t>(offset);
+    while (length) {
+        ssize_t copied = ::copy_file_range(m_jsonFile->handle(), &position, fd, nullptr, length, 0);
+        if (copied <= 0) {
+            if (copied < 0 && errno == EINTR)
+                continue;
+            break;
+        }
+        length -= static_cast<size_t>(copied);
+    }
+    offset = static_cast<size_t>(position);
+#endif
+
+    if (!length)
+        return true;
+
+    return writeAll(fd, m_jsonFile->contents().data() + offset, length);
+}
+
+bool RecordExporter::writeRaw(int fd, const std::vector<size_t>& rows, const Progress& progress, QString* error)
+{
+    std::vector<iovec> iov;
+    iov.reserve(IOV_BATCH);
+
+    auto flush = [&]() {
+        bool ok = writeAll(fd, iov.data(), iov.size());
+        iov.clear();
+        return ok;
+    };
+
+    size_t done = 0;
+    size_t reported = 0;
+    size_t i = 0;
+    while (i < rows.size()) {
+        size_t run = runLength(rows, i);
+
+        if (run >= COPY_RUN_MIN) {
+            auto first = m_jsonFile->lineText(rows[i]);
+            auto last = m_jsonFile->lineText(rows[i + run - 1]);
+            size_t offset = m_jsonFile->lineOffset(rows[i]);
+            size_t length = (last.data() + last.size()) - first.data();
+
+            if (!flush() || !copyRange(fd, offset, length) || !writeAll(fd, &NEWLINE, 1)) {
+                if (error)
+                    *error = systemError("Write failed");
+                return false;
+            }
+            i += run;
+            done += run;
+        } else {
+            for (size_t end = i + run; i < end; ++i) {
+                auto text = m_jsonFile->lineText(rows[i]);
+                iov.push_back(iovec{const_cast<char*>(text.data()), text.size()});
+                iov.push_back(iovec{const_cast<char*>(&NEWLINE), 1});
+
+                if (iov.size() >= IOV_BATCH && !flush()) {
+                    if (error)
+                        *error = systemError("Write failed");
+                    return false;
+                }
+            }
+            done += run;
+        }
+
+        if (done - reported >= PROGRESS_STEP) {
+            reported = done;
+            if (progress && !progress(done)) {
+                if (error)
+                    *error = "Canceled";
+                return false;
+            }
+        }
+    }
+
+    if (!flush()) {
+        if (error)
+            *error = systemError("Write failed");
+        return false;
+    }
+
+    if (progress)
+        progress(done);
+    return true;
+}
+
+bool RecordExporter::writeFormatted(int fd, const std::vector<size_t>& rows, const Progress& progress, QString* error)
+{
+    FdWriteStream stream(fd);
+    rapidjson::Writer<FdWriteStream> writer(stream);
+    rapidjson::PrettyWriter<FdWriteStream> prettyWriter(stream);
+
+    for (size_t i = 0; i < rows.size(); ++i) {
+        auto text = m_jsonFile->lineText(rows[i]);
+
+        rapidjson::Document doc;
+        doc.Parse(text.data(), text.size());
+
+        if (doc.HasParseError()) {
+            // keep records that don't parse as they are
+            stream.Write(text);
+        } else if (m_format == Format::Pretty) {
+            prettyWriter.Reset(stream);
+            doc.Accept(prettyWriter);
+        } else {
+            writer.Reset(stream);
+            doc.Accept(writer);
+        }
+        stream.Put(NEWLINE);
+
+        if (stream.failed()) {
+            if (error)
+                *error = systemError("Write failed");
+            return false;
+        }
+
+        if ((i + 1) % PROGRESS_STEP == 0 && progress && !progress(i + 1)) {
+            if (error)
+                *error = "Canceled";
+            return false;
+        }
+    }
+
+    stream.Flush();
+    if (stream.failed()) {
+        if (error)
+            *error = systemError("Write failed");
+        return false;
+    }
+
+    if (progress)
+        progress(rows.size());
+    return true;
+}
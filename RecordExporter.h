@@ -0,0 +1,38 @@
+#pragma once
+
+#include "JsonFile.h"
+
+#include <QString>
+
+#include <functional>
+#include <vector>
+
+// Writes records to a JSONL file. Raw export copies record bytes straight from
+// the mapped file, reformatting goes through a streaming writer.
+class RecordExporter
+{
+public:
+    enum class Format
+    {
+        Raw,
+        Minified,
+        Pretty,
+    };
+
+    // called with the number of records written, returns false to cancel
+    using Progress = std::function<bool(size_t)>;
+
+    RecordExporter(const JsonFile* jsonFile, Format format);
+
+    // rows must be sorted
+    bool write(const std::vector<size_t>& rows, const QString& path, const Progress& progress, QString* error);
+
+private:
+    const JsonFile* m_jsonFile;
+    Format m_format;
+
+    bool writeRaw(int fd, const std::vector<size_t>& rows, const Progress& progress, QString* error);
+    bool writeFormatted(int fd, const std::vector<size_t>& rows, const Progress& progress, QString* error);
+    bool copyRange(int fd, size_t offset, size_t length);
+    size_t runLength(const std::vector<size_t>& rows, size_t start) const;
+};
@@ -0,0 +1,298 @@
+#include "Sketches.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+    uint64_t mix(uint64_t x)
+    {
+        x ^= x >> 33;
+        x *= 0xff51afd7ed558ccdULL;
+        x ^= x >> 33;
+        x *= 0xc4ceb9fe1a85ec53ULL;
+        x ^= x >> 33;
+        return x;
+    }
+}
+
+uint64_t hashBytes(std::string_view bytes)
+{
+    // FNV-1a, finalized so that all bits are usable
+    uint64_t hash = 1469598103934665603ULL;
+    for (unsigned char c : bytes) {
+        hash ^= c;
+        hash *= 1099511628211ULL;
+    }
+    return mix(hash);
+}
+
+//
+// HyperLogLog
+//
+
+HyperLogLog::HyperLogLog()
+    : m_registers(size_t(1) << PRECISION, 0)
+{
+}
+
+void HyperLogLog::add(uint64_t hash)
+{
+    size_t index = hash >> (64 - PRECISION);
+    uint64_t rest = (hash << PRECISION) | (uint64_t(1) << (PRECISION - 1));
+    uint8_t rank = static_cast<uint8_t>(__builtin_clzll(rest) + 1);
+    m_registers[index] = std::max(m_registers[index], rank);
+}
+
+void HyperLogLog::merge(const HyperLogLog& other)
+{
+    for (size_t i = 0; i < m_registers.size(); ++i)
+        m_registers[i] = std::max(m_registers[i], other.m_registers[i]);
+}
+
+double HyperLogLog::estimate() const
+{
+    const double m = static_cast<double>(m_registers.size());
+    double sum = 0;
+    size_t zeros = 0;
+
+    for (uint8_t r : m_registers) {
+        sum += std::ldexp(1.0, -r);
+        if (r == 0)
+            zeros++;
+    }
+
+    const double alpha = 0.7213 / (1 + 1.079 / m);
+    double estimate = alpha * m * m / sum;
+
+    // small range correction
+    if (estimate <= 2.5 * m && zeros != 0)
+        estimate = m * std::log(m / static_cast<double>(zeros));
+
+    return estimate;
+}
+
+//
+// TopValues
+//
+
+TopValues::TopValues()
+    : m_counts(DEPTH * WIDTH, 0)
+{
+}
+
+size_t TopValues::cell(size_t row, uint64_t hash) const
+{
+    return row * WIDTH + (mix(hash + row * 0x9e3779b97f4a7c15ULL) % WIDTH);
+}
+
+uint64_t TopValues::estimate(uint64_t hash) const
+{
+    uint64_t result = UINT64_MAX;
+    for (size_t row = 0; row < DEPTH; ++row)
+        result = std::min<uint64_t>(result, m_counts[cell(row, hash)]);
+    return result;
+}
+
+void TopValues::add(std::string_view value, uint64_t hash)
+{
+    for (size_t row = 0; row < DEPTH; ++row)
+        m_counts[cell(row, hash)]++;
+
+    offer(Entry{std::string(), hash, estimate(hash)});
+    // the value text is only stored when it becomes a candidate
+    for (auto& entry : m_candidates) {
+        if (entry.hash == hash && entry.value.empty())
+            entry.value = std::string(value.substr(0, MAX_VALUE_LENGTH));
+    }
+}
+
+void TopValues::offer(const Entry& entry)
+{
+    for (auto& candidate : m_candidates) {
+        if (candidate.hash == entry.hash) {
+            candidate.count = std::max(candidate.count, entry.count);
+            return;
+        }
+    }
+
+    if (m_candidates.size() < CANDIDATES) {
+        m_candidates.push_back(entry);
+        return;
+    }
+
+    auto lowest = std::min_element(m_candidates.begin(), m_candidates.end(), [](const Entry& a, const Entry& b) {
+        return a.count < b.count;
+    });
+    if (lowest->count < entry.count)
+        *lowest = entry;
+}
+
+void TopValues::merge(const TopValues& other)
+{
+    for (size_t i = 0; i < m_counts.size(); ++i)
+        m_counts[i] += other.m_counts[i];
+
+    // counts of all candidates are re-estimated from the combined counters
+    std::vector<Entry> candidates = std::move(m_candidates);
+    candidates.insert(candidates.end(), other.m_candidates.begin(), other.m_candidates.end());
+    m_candidates.clear();
+
+    for (auto& entry : candidates) {
+        entry.count = estimate(entry.hash);
+        offer(entry);
+        for (auto& candidate : m_candidates) {
+            if (candidate.hash == entry.hash && candidate.value.empty())
+                candidate.value = entry.value;
+        }
+    }
+}
+
+std::vector<TopValues::Entry> TopValues::top(size_t count) const
+{
+    std::vector<Entry> result = m_candidates;
+    std::sort(result.begin(), result.end(), [](const Entry& a, const Entry& b) {
+        return a.count > b.count;
+    });
+    if (result.size() > count)
+        result.resize(count);
+    return result;
+}
+
+//
+// TDigest
+//
+
+TDigest::TDigest(double compression)
+    : m_compression(compression)
+{
+}
+
+void TDigest::add(double value)
+{
+    if (std::isnan(value))
+        return;
+
+    m_buffer.push_back(Centroid{value, 1});
+    m_total += 1;
+
+    if (m_buffer.size() >= static_cast<size_t>(m_compression * 5))
+        compress();
+}
+
+void TDigest::merge(const TDigest& other)
+{
+    m_buffer.insert(m_buffer.end(), other.m_centroids.begin(), other.m_centroids.end());
+    m_buffer.insert(m_buffer.end(), other.m_buffer.begin(), other.m_buffer.end());
+    m_total += other.m_total;
+    compress();
+}
+
+double TDigest::count() const
+{
+    return m_total;
+}
+
+size_t TDigest::memoryBound(double compression)
+{
+    // a buffer of up to 5x the compression with vector slack, and the centroids
+    return sizeof(TDigest) + static_cast<size_t>(compression * 12) * sizeof(Centroid);
+}
+
+std::vector<TDigest::Centroid> TDigest::centroids() const
+{
+    if (m_buffer.empty())
+        return m_centroids;
+
+    TDigest copy(*this);
+    copy.compress();
+    return copy.m_centroids;
+}
+
+void TDigest::compress()
+{
+    if (m_buffer.empty())
+        return;
+
+    std::vector<Centroid> all = std::move(m_centroids);
+    all.insert(all.end(), m_buffer.begin(), m_buffer.end());
+    m_buffer.clear();
+
+    std::sort(all.begin(), all.end(), [](const Centroid& a, const Centroid& b) {
+        return a.mean < b.mean;
+    });
+
+    // merge neighbours while the centroid stays below the size limit for its quantile
+    m_centroids.clear();
+    double cumulative = 0;
+    Centroid current = all.front();
+
+    for (size_t i = 1; i < all.size(); ++i) {
+        const Centroid& next = all[i];
+        double weight = current.weight + next.weight;
+        double q = (cumulative + weight / 2) / m_total;
+        double limit = 4 * m_total * q * (1 - q) / m_compression;
+
+        if (weight <= std::max(1.0, limit)) {
+            current.mean += (next.mean - current.mean) * next.weight / weight;
+            current.weight = weight;
+        } else {
+            cumulative += current.weight;
+            m_centroids.push_back(current);
+            current = next;
+        }
+    }
+    m_centroids.push_back(current);
+}
+
+double TDigest::quantile(double q) const
+{
+    auto list = centroids();
+    if (list.empty())
+        return NAN;
+    if (list.size() == 1)
+        return list.front().mean;
+
+    q = std::clamp(q, 0.0, 1.0);
+    const double target = q * m_total;
+
+    // interpolate between centroid centers
+    double cumulative = list.front().weight / 2;
+    if (target <= cumulative)
+        return list.front().mean;
+
+    for (size_t i = 1; i < list.size(); ++i) {
+        double step = (list[i - 1].weight + list[i].weight) / 2;
+        if (target <= cumulative + step) {
+            double t = (target - cumulative) / step;
+            return list[i - 1].mean + t * (list[i].mean - list[i - 1].mean);
+        }
+        cumulative += step;
+    }
+
+    return list.back().mean;
+}
+
+double TDigest::cdf(double value) const
+{
+    auto list = centroids();
+    if (list.empty())
+        return NAN;
+
+    if (value < list.front().mean)
+        return 0;
+    if (value >= list.back().mean)
+        return 1;
+
+    double cumulative = list.front().weight / 2;
+    for (size_t i = 1; i < list.size(); ++i) {
+        double step = (list[i - 1].weight + list[i].weight) / 2;
+        if (value < list[i].mean) {
+            double t = (value - list[i - 1].mean) / (list[i].mean - list[i - 1].mean);
+            return (cumulative + t * step) / m_total;
+        }
+        cumulative += step;
+    }
+
+    return 1;
+}
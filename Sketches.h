@@ -0,0 +1,93 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Mergeable summaries used by column statistics. Each of them can be filled
+// independently per chunk of records and combined afterwards.
+
+uint64_t hashBytes(std::string_view bytes);
+
+// approximate number of distinct values
+class HyperLogLog
+{
+public:
+    static constexpr int PRECISION = 14;
+
+    HyperLogLog();
+
+    void add(uint64_t hash);
+    void merge(const HyperLogLog& other);
+    double estimate() const;
+
+private:
+    std::vector<uint8_t> m_registers;
+};
+
+// approximate frequency of values, keeps a few heavy hitters as candidates
+class TopValues
+{
+public:
+    static constexpr size_t DEPTH = 4;
+    static constexpr size_t WIDTH = 2048;
+    static constexpr size_t CANDIDATES = 32;
+    static constexpr size_t MAX_VALUE_LENGTH = 200;
+
+    struct Entry
+    {
+        std::string value;
+        uint64_t hash;
+        uint64_t count;
+    };
+
+    TopValues();
+
+    void add(std::string_view value, uint64_t hash);
+    void merge(const TopValues& other);
+
+    uint64_t estimate(uint64_t hash) const;
+    // most frequent values, highest count first
+    std::vector<Entry> top(size_t count) const;
+
+private:
+    std::vector<uint32_t> m_counts; // DEPTH rows of WIDTH counters
+    std::vector<Entry> m_candidates;
+
+    size_t cell(size_t row, uint64_t hash) const;
+    void offer(const Entry& entry);
+};
+
+// approximate quantiles of numeric values (merging t-digest)
+class TDigest
+{
+public:
+    explicit TDigest(double compression = 100);
+
+    void add(double value);
+    void merge(const TDigest& other);
+
+    double quantile(double q) const;
+    double cdf(double value) const;
+    double count() const;
+
+    // most memory a digest of `compression` holds, the buffer included
+    static size_t memoryBound(double compression = 100);
+
+private:
+    struct Centroid
+    {
+        double mean;
+        double weight;
+    };
+
+    double m_compression;
+    double m_total = 0;
+    std::vector<Centroid> m_centroids; // sorted by mean
+    std::vector<Centroid> m_buffer;    // values not merged yet
+
+    void compress();
+    // centroids including the buffered values
+    std::vector<Centroid> centroids() const;
+};
@@ -0,0 +1,175 @@
+#include "StatisticsPanel.h"
+#include "Locale.h"
+
+#include <QVBoxLayout>
+#include <QHeaderView>
+#include <QtConcurrent/QtConcurrent>
+
+namespace
+{
+    const size_t MIN_CHUNK_RECORDS = 4096;
+    const size_t MAX_CHUNKS = 256;    // chunk summaries are kept by the future until done
+    const int REFRESH_INTERVAL_MS = 200;
+    const size_t TOP_VALUES = 10;
+    const size_t HISTOGRAM_BINS = 16;
+    const int HISTOGRAM_WIDTH = 30;
+
+    struct Chunk
+    {
+        size_t first;
+        size_t last;
+    };
+
+    QString percent(size_t part, size_t total)
+    {
+        return total ? QString("%1%").arg(locale.toString(100.0 * part / total, 'f', 1)) : QString();
+    }
+}
+
+StatisticsPanel::StatisticsPanel(JsonFile* jsonFile, QWidget* parent)
+    : QWidget(parent), m_jsonFile(jsonFile)
+{
+    m_title = new QLabel("Select \"Column statistics\" in the table header menu", this);
+    m_title->setWordWrap(true);
+
+    m_progress = new QProgressBar(this);
+    m_progress->hide();
+
+    m_view = new QTreeWidget(this);
+    m_view->setColumnCount(3);
+    m_view->setHeaderLabels({"Name", "Value", ""});
+    m_view->setRootIsDecorated(true);
+    m_view->header()->setSectionResizeMode(QHeaderView::ResizeToContents);
+
+    auto* layout = new QVBoxLayout(this);
+    layout->setContentsMargins(2, 2, 2, 2);
+    layout->addWidget(m_title);
+    layout->addWidget(m_progress);
+    layout->addWidget(m_view);
+
+    connect(&m_watcher, &QFutureWatcher<ColumnStats>::resultReadyAt, this, &StatisticsPanel::onChunkReady);
+    connect(&m_watcher, &QFutureWatcher<ColumnStats>::finished, this, &StatisticsPanel::onFinished);
+}
+
+StatisticsPanel::~StatisticsPanel()
+{
+    cancel();
+}
+
+void StatisticsPanel::cancel()
+{
+    if (m_future.isRunning()) {
+        m_future.cancel();
+        m_future.waitForFinished();
+    }
+}
+
+void StatisticsPanel::compute(const JsonPath& path)
+{
+    cancel();
+
+    m_stats = ColumnStats();
+    m_column = path.text();
+
+    const size_t records = m_jsonFile->size();
+    const size_t chunkSize = std::max(MIN_CHUNK_RECORDS, (records + MAX_CHUNKS - 1) / MAX_CHUNKS);
+
+    QList<Chunk> chunks;
+    for (size_t first = 0; first < records; first += chunkSize)
+        chunks.append(Chunk{first, std::min(records, first + chunkSize)});
+
+    m_progress->setRange(0, static_cast<int>(chunks.size()));
+    m_progress->setValue(0);
+    m_progress->setVisible(!chunks.isEmpty());
+
+    // the worker only reads raw record text, parsed records of the table are not touched
+    const JsonFile* jsonFile = m_jsonFile;
+    m_future = QtConcurrent::mapped(chunks, [jsonFile, path](const Chunk& chunk) {
+        ColumnStats stats;
+        for (size_t row = chunk.first; row < chunk.last; ++row) {
+            auto text = jsonFile->lineText(row);
+            rapidjson::Document doc;
+            doc.Parse(text.data(), text.size());
+            stats.add(doc.HasParseError() ? nullptr : path.extract(doc));
+        }
+        return stats;
+    });
+
+    m_refreshTimer.start();
+    m_watcher.setFuture(m_future);
+    refresh();
+}
+
+void StatisticsPanel::onChunkReady(int index)
+{
+    m_stats.merge(m_future.resultAt(index));
+    m_progress->setValue(m_progress->value() + 1);
+
+    if (m_refreshTimer.elapsed() >= REFRESH_INTERVAL_MS) {
+        m_refreshTimer.restart();
+        refresh();
+    }
+}
+
+void StatisticsPanel::onFinished()
+{
+    m_progress->hide();
+    refresh();
+}
+
+void StatisticsPanel::refresh()
+{
+    const auto& s = m_stats;
+    m_title->setText(QString("Column: %1").arg(m_column));
+    m_view->clear();
+
+    auto addRow = [](QTreeWidgetItem* parent, const QString& name, const QString& value, const QString& extra = QString()) {
+        return new QTreeWidgetItem(parent, {name, value, extra});
+    };
+
+    auto* summary = new QTreeWidgetItem(m_view, {"Summary"});
+    addRow(summary, "Records", locale.toString(qulonglong(s.records)));
+    addRow(summary, "Missing", locale.toString(qulonglong(s.missing)), percent(s.missing, s.records));
+    addRow(summary, "Null", locale.toString(qulonglong(s.nulls)), percent(s.nulls, s.records));
+    addRow(summary, "Distinct (approx.)", locale.toString(qulonglong(s.distinct.estimate() + 0.5)));
+
+    auto* types = new QTreeWidgetItem(m_view, {"Types"});
+    addRow(types, "number", locale.toString(qulonglong(s.numbers)), percent(s.numbers, s.records));
+    addRow(types, "string", locale.toString(qulonglong(s.strings)), percent(s.strings, s.records));
+    addRow(types, "boolean", locale.toString(qulonglong(s.booleans)), percent(s.booleans, s.records));
+    addRow(types, "object", locale.toString(qulonglong(s.objects)), percent(s.objects, s.records));
+    addRow(types, "array", locale.toString(qulonglong(s.arrays)), percent(s.arrays, s.records));
+
+    if (s.numbers) {
+        auto* numbers = new QTreeWidgetItem(m_view, {"Numbers"});
+        addRow(numbers, "Min", locale.toString(s.min));
+        addRow(numbers, "Max", locale.toString(s.max));
+        addRow(numbers, "Mean", locale.toString(s.sum / s.numbers));
+        addRow(numbers, "p50", locale.toString(s.digest.quantile(0.50)));
+        addRow(numbers, "p90", locale.toString(s.digest.quantile(0.90)));
+        addRow(numbers, "p99", locale.toString(s.digest.quantile(0.99)));
+    }
+
+    const size_t values = s.records - s.missing;
+    auto* top = new QTreeWidgetItem(m_view, {"Top values"});
+    for (const auto& entry : s.topValues.top(TOP_VALUES)) {
+        addRow(top, QString::fromUtf8(entry.value.data(), entry.value.size()),
+            locale.toString(qulonglong(entry.count)), percent(entry.count, values));
+    }
+
+    auto bins = s.histogram(HISTOGRAM_BINS);
+    if (!bins.empty()) {
+        auto* histogram = new QTreeWidgetItem(m_view, {"Histogram"});
+        double highest = 0;
+        for (const auto& bin : bins)
+            highest = std::max(highest, bin.count);
+
+        for (const auto& bin : bins) {
+            int width = highest > 0 ? static_cast<int>(HISTOGRAM_WIDTH * bin.count / highest + 0.5) : 0;
+            addRow(histogram, QString("%1 \u2013 %2").arg(locale.toString(bin.from), locale.toString(bin.to)),
+                locale.toString(qulonglong(bin.count + 0.5)), QString(width, QChar(0x2588)));
+        }
+    }
+
+    m_view->expandAll();
+}
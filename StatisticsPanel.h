@@ -0,0 +1,44 @@
+#pragma once
+
+#include "JsonFile.h"
+#include "JsonPath.h"
+#include "ColumnStats.h"
+
+#include <QWidget>
+#include <QLabel>
+#include <QProgressBar>
+#include <QTreeWidget>
+#include <QFuture>
+#include <QFutureWatcher>
+#include <QElapsedTimer>
+
+// Statistics of one column over all records, computed in parallel over chunks
+// of records and refreshed as chunk summaries are merged.
+class StatisticsPanel : public QWidget
+{
+    Q_OBJECT
+
+public:
+    explicit StatisticsPanel(JsonFile* jsonFile, QWidget* parent = nullptr);
+    ~StatisticsPanel() override;
+
+    void compute(const JsonPath& path);
+    void cancel();
+
+private:
+    JsonFile* m_jsonFile;
+    QLabel* m_title;
+    QProgressBar* m_progress;
+    QTreeWidget* m_view;
+
+    QFuture<ColumnStats> m_future;
+    QFutureWatcher<ColumnStats> m_watcher;
+    QElapsedTimer m_refreshTimer;
+
+    ColumnStats m_stats;
+    QString m_column;
+
+    void onChunkReady(int index);
+    void onFinished();
+    void refresh();
+};
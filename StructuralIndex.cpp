@@ -0,0 +1,172 @@
+#include "StructuralIndex.h"
+#include "json.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace
+{
+    bool isBlank(char c)
+    {
+        return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+    }
+
+    struct Open
+    {
+        size_t offset;
+        uint32_t commas;
+        bool empty;
+    };
+}
+
+StructuralIndex::StructuralIndex(std::string_view text, size_t minBytes)
+    : m_text(text)
+{
+    size_t start = 0;
+    while (start < text.size() && isBlank(text[start]))
+        ++start;
+    if (start == text.size() || (text[start] != '{' && text[start] != '['))
+        return;
+
+    // containers are complete when they close, so they're found in post-order
+    std::vector<Open> stack;
+    bool closed = false;
+    for (size_t i = start; i < text.size() && !closed; ++i) {
+        switch (text[i]) {
+            case '"': {
+                if (!stack.empty())
+                    stack.back().empty = false;
+                i = stringEnd(i, text.size());
+                if (!i) {
+                    m_nodes.clear();
+                    return;
+                }
+                --i;
+                break;
+            }
+            case '{': case '[':
+                if (!stack.empty())
+                    stack.back().empty = false;
+                stack.push_back(Open{i, 0, true});
+                break;
+            case '}': case ']': {
+                const Open open = stack.back();
+                stack.pop_back();
+                const size_t length = i + 1 - open.offset;
+                closed = stack.empty();
+                if (closed || length >= minBytes)
+                    m_nodes.push_back(Node{open.offset, length, open.empty ? 0 : open.commas + 1, 0});
+                break;
+            }
+            case ',':
+                if (!stack.empty())
+                    ++stack.back().commas;
+                break;
+            default:
+                if (!stack.empty() && !isBlank(text[i]))
+                    stack.back().empty = false;
+        }
+    }
+
+    if (!closed) {
+        m_nodes.clear();
+        return;
+    }
+
+    // document order puts parents before children, then a subtree ends at the first
+    // node starting after its container
+    std::sort(m_nodes.begin(), m_nodes.end(), [](const Node& a, const Node& b) { return a.offset < b.offset; });
+    std::vector<uint32_t> ancestors;
+    for (uint32_t i = 0; i < m_nodes.size(); ++i) {
+        while (!ancestors.empty() && m_nodes[i].offset >= m_nodes[ancestors.back()].offset + m_nodes[ancestors.back()].length) {
+            m_nodes[ancestors.back()].next = i;
+            ancestors.pop_back();
+        }
+        ancestors.push_back(i);
+    }
+    for (uint32_t i : ancestors)
+        m_nodes[i].next = static_cast<uint32_t>(m_nodes.size());
+    m_nodes.shrink_to_fit();
+}
+
+size_t StructuralIndex::skipSeparators(size_t offset, size_t end) const
+{
+    while (offset < end && (isBlank(m_text[offset]) || m_text[offset] == ','))
+        ++offset;
+    return offset;
+}
+
+size_t StructuralIndex::stringEnd(size_t offset, size_t end) const
+{
+    const char* p = m_text.data() + offset + 1;
+    const char* last = m_text.data() + end;
+    while (p < last) {
+        const char* quote = static_cast<const char*>(std::memchr(p, '"', last - p));
+        if (!quote)
+            return 0;
+
+        // escaped when preceded by an odd number of backslashes
+        size_t backslashes = 0;
+        while (quote - backslashes > p && quote[-1 - static_cast<ptrdiff_t>(backslashes)] == '\\')
+            ++backslashes;
+        if (backslashes % 2 == 0)
+            return quote + 1 - m_text.data();
+        p = quote + 1;
+    }
+    return 0;
+}
+
+void StructuralIndex::forEachChild(uint32_t node, size_t from, const std::function<bool(const Child&)>& visit) const
+{
+    const Node& parent = m_nodes[node];
+    const bool object = isObject(node);
+    const size_t end = parent.offset + parent.length - 1; // the closing bracket
+    size_t p = std::max(from, parent.offset + 1);
+
+    // the first indexed node from there is a child, later ones are reached by skip pointers
+    auto first = std::lower_bound(m_nodes.begin() + node + 1, m_nodes.begin() + parent.next, p, [](const Node& n, size_t offset) {
+        return n.offset < offset;
+    });
+    uint32_t next = static_cast<uint32_t>(first - m_nodes.begin());
+
+    while ((p = skipSeparators(p, end)) < end) {
+        Child child{p, std::string_view(), std::string_view(), NO_NODE};
+
+        if (object) {
+            if (m_text[p] != '"')
+                return;
+            const size_t keyEnd = stringEnd(p, end);
+            if (!keyEnd)
+                return;
+            child.key = m_text.substr(p, keyEnd - p);
+
+            p = keyEnd;
+            while (p < end && isBlank(m_text[p]))
+                ++p;
+            if (p == end || m_text[p] != ':')
+                return;
+            ++p;
+            while (p < end && isBlank(m_text[p]))
+                ++p;
+            if (p == end)
+                return;
+        }
+
+        size_t length = 0;
+        if (next < parent.next && m_nodes[next].offset == p) {
+            length = m_nodes[next].length;
+            child.node = next;
+            next = m_nodes[next].next;
+        } else {
+            auto range = matchJsonValue(m_text.data() + p, end - p);
+            if (!range)
+                return;
+            length = range->end - (m_text.data() + p);
+        }
+
+        child.value = m_text.substr(p, length);
+        if (!visit(child))
+            return;
+        p += length;
+    }
+}
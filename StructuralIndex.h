@@ -0,0 +1,63 @@
+#pragma once
+
+#include "constants.h"
+
+#include <cstdint>
+#include <functional>
+#include <string_view>
+#include <vector>
+
+// Positions of the large containers of one JSON document, found in a single pass
+// without building a DOM. Nodes are kept in document order, each knows where its
+// subtree ends, so the children of a container are listed by tokenizing only its
+// own bytes and jumping over large descendants. Containers smaller than
+// `minBytes` are not indexed, they are cheap to parse when needed. Nested
+// containers cover the same bytes, so there are at most depth * size / minBytes
+// nodes.
+class StructuralIndex
+{
+public:
+    static constexpr uint32_t NO_NODE = UINT32_MAX;
+
+    struct Node
+    {
+        size_t offset;      // of the opening bracket in the text
+        size_t length;
+        uint32_t children;
+        uint32_t next;      // first node after the subtree, a skip pointer
+    };
+
+    struct Child
+    {
+        size_t offset;          // of the key for members, of the value for elements
+        std::string_view key;   // JSON string including quotes, empty for elements
+        std::string_view value;
+        uint32_t node;          // NO_NODE when the value is not indexed
+    };
+
+    explicit StructuralIndex(std::string_view text, size_t minBytes = STRUCTURAL_INDEX_MIN_BYTES);
+
+    // false when the text is not a single object or array
+    bool valid() const { return !m_nodes.empty(); }
+    std::string_view text() const { return m_text; }
+
+    // node 0 is the document itself
+    const Node& node(uint32_t index) const { return m_nodes[index]; }
+    size_t size() const { return m_nodes.size(); }
+    bool isObject(uint32_t index) const { return m_text[m_nodes[index].offset] == '{'; }
+    std::string_view source(uint32_t index) const { return m_text.substr(m_nodes[index].offset, m_nodes[index].length); }
+
+    // visits children of `node` from the child starting at or after `from` until `visit`
+    // returns false, a malformed child ends the list
+    void forEachChild(uint32_t node, size_t from, const std::function<bool(const Child&)>& visit) const;
+
+    size_t memoryUsage() const { return m_nodes.capacity() * sizeof(Node); }
+
+private:
+    std::string_view m_text;
+    std::vector<Node> m_nodes;
+
+    size_t skipSeparators(size_t offset, size_t end) const;
+    // offset after the closing quote of the string at `offset`, 0 when it doesn't end before `end`
+    size_t stringEnd(size_t offset, size_t end) const;
+};
@@ -0,0 +1,510 @@
+#include "SyntheticData.h"
+
+#include <algorithm>
+#include <cstdio>
+
+namespace synthetic
+{
+    namespace
+    {
+        // splitmix64, cheap and stable across platforms unlike std distributions
+        uint64_t next(uint64_t& state)
+        {
+            uint64_t z = (state += 0x9e3779b97f4a7c15ULL);
+            z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+            z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+            return z ^ (z >> 31);
+        }
+
+        uint64_t below(uint64_t& state, uint64_t bound)
+        {
+            return bound ? next(state) % bound : 0;
+        }
+
+        constexpr size_t CHUNK_BYTES = 4 * 1024 * 1024;
+
+        const char* const WORDS[] = {
+            "alpha", "bravo", "charlie", "delta", "echo", "foxtrot", "golf", "hotel",
+            "india", "juliett", "kilo", "lima", "mike", "november", "oscar", "papa",
+            "quebec", "romeo", "sierra", "tango", "uniform", "victor", "whiskey", "xray",
+        };
+        constexpr size_t WORD_COUNT = sizeof(WORDS) / sizeof(WORDS[0]);
+
+        const char* const LEVELS[] = {"debug", "info", "warning", "error"};
+
+        // escapes and multi-byte characters, as they appear in the source text
+        const char* const ESCAPED[] = {
+            "\\n", "\\t", "\\\"", "\\\\", "\\/", "\\u00e9", "\\u2603", "\\ud83d\\ude00", "\xc3\xa9", "\xe2\x82\xac",
+        };
+        constexpr size_t ESCAPED_COUNT = sizeof(ESCAPED) / sizeof(ESCAPED[0]);
+
+        void appendNumber(std::string& out, uint64_t value)
+        {
+            char buffer[24];
+            int length = std::snprintf(buffer, sizeof(buffer), "%llu", static_cast<unsigned long long>(value));
+            out.append(buffer, length);
+        }
+
+        void appendDouble(std::string& out, double value)
+        {
+            char buffer[32];
+            int length = std::snprintf(buffer, sizeof(buffer), "%.6g", value);
+            out.append(buffer, length);
+        }
+
+        void appendWords(std::string& out, uint64_t& state, size_t count, char separator = ' ')
+        {
+            out += '"';
+            for (size_t i = 0; i < count; ++i) {
+                if (i)
+                    out += separator;
+                out += WORDS[below(state, WORD_COUNT)];
+            }
+            out += '"';
+        }
+
+        void appendKey(std::string& out, std::string_view key)
+        {
+            out += '"';
+            out += key;
+            out += "\":";
+        }
+
+        void flat(std::string& out, size_t index, uint64_t& state)
+        {
+            out += '{';
+            appendKey(out, "id");
+            appendNumber(out, index);
+            out += ',';
+            appendKey(out, "ts");
+            appendNumber(out, 1700000000000ULL + index * 1000 + below(state, 1000));
+            out += ',';
+            appendKey(out, "level");
+            out += '"';
+            out += LEVELS[below(state, 4)];
+            out += "\",";
+            appendKey(out, "user");
+            appendWords(out, state, 1);
+            out += ',';
+            appendKey(out, "latency");
+            appendDouble(out, double(below(state, 100000)) / 100.0);
+            out += ',';
+            appendKey(out, "ok");
+            out += below(state, 10) ? "true" : "false";
+            out += ',';
+            appendKey(out, "message");
+            appendWords(out, state, 4 + below(state, 12));
+            out += '}';
+        }
+
+        void log(std::string& out, size_t index, uint64_t& state)
+        {
+            out += '{';
+            appendKey(out, "@timestamp");
+            appendNumber(out, 1700000000000ULL + index * 37 + below(state, 37));
+            out += ',';
+            appendKey(out, "level");
+            out += '"';
+            out += LEVELS[below(state, 4)];
+            out += "\",";
+            appendKey(out, "logger");
+            appendWords(out, state, 3, '.');
+            out += ',';
+            appendKey(out, "thread");
+            appendNumber(out, below(state, 64));
+            out += ',';
+            appendKey(out, "trace");
+            out += "{\"id\":";
+            appendNumber(out, next(state));
+            out += ",\"span\":";
+            appendNumber(out, next(state));
+            out += ",\"sampled\":";
+            out += below(state, 2) ? "true" : "false";
+            out += "},";
+            appendKey(out, "http");
+            out += "{\"status\":";
+            appendNumber(out, below(state, 20) ? 200 : 500 + below(state, 4));
+            out += ",\"bytes\":";
+            appendNumber(out, below(state, 1 << 20));
+            out += ",\"duration_ms\":";
+            appendDouble(out, double(below(state, 1000000)) / 1000.0);
+            out += "},";
+            appendKey(out, "message");
+            appendWords(out, state, 90 + below(state, 40));
+            out += '}';
+        }
+
+        void nested(std::string& out, size_t index, uint64_t& state)
+        {
+            out += '{';
+            appendKey(out, "id");
+            appendNumber(out, index);
+            out += ',';
+            appendKey(out, "request");
+            out += '{';
+            appendKey(out, "method");
+            out += below(state, 3) ? "\"GET\"," : "\"POST\",";
+            appendKey(out, "path");
+            appendWords(out, state, 3, '/');
+            out += ',';
+            appendKey(out, "headers");
+            out += '{';
+            size_t headers = 3 + below(state, 6);
+            for (size_t i = 0; i < headers; ++i) {
+                if (i)
+                    out += ',';
+                out += "\"x-";
+                out += WORDS[i % WORD_COUNT];
+                out += "\":";
+                appendWords(out, state, 2, '-');
+            }
+            out += "}},";
+            appendKey(out, "items");
+            out += '[';
+            size_t items = 2 + below(state, 20);
+            for (size_t i = 0; i < items; ++i) {
+                if (i)
+                    out += ',';
+                out += '{';
+                appendKey(out, "sku");
+                appendNumber(out, below(state, 100000));
+                out += ',';
+                appendKey(out, "price");
+                appendDouble(out, double(below(state, 1000000)) / 100.0);
+                out += ',';
+                appendKey(out, "tags");
+                out += '[';
+                size_t tags = below(state, 4);
+                for (size_t t = 0; t < tags; ++t) {
+                    if (t)
+                        out += ',';
+                    appendWords(out, state, 1);
+                }
+                out += "]}";
+            }
+            out += "],";
+            appendKey(out, "note");
+            // escapes and a multiline string now and then
+            out += below(state, 8) ? "\"plain\"" : "\"line one\\nline \\\"two\\\"\\tend\"";
+            out += '}';
+        }
+
+        void document(std::string& out, size_t index, uint64_t& state, const Options& options)
+        {
+            // a nested record made of sections of nested records
+            const size_t start = out.size();
+            out += '{';
+            appendKey(out, "id");
+            appendNumber(out, index);
+            out += ',';
+            appendKey(out, "sections");
+            out += '[';
+            size_t section = 0;
+            while (out.size() - start < options.recordBytes) {
+                if (section)
+                    out += ',';
+                out += "{\"name\":";
+                appendWords(out, state, 2);
+                out += ",\"entries\":[";
+                for (size_t i = 0; i < 32; ++i) {
+                    if (i)
+                        out += ',';
+                    nested(out, section * 32 + i, state);
+                }
+                out += "]}";
+                ++section;
+            }
+            out += "]}";
+        }
+
+        void wide(std::string& out, size_t index, uint64_t& state, const Options& options)
+        {
+            out += '{';
+            appendKey(out, "id");
+            appendNumber(out, index);
+            // each record has about a quarter of all keys
+            for (size_t key = 0; key < options.wideKeys; ++key) {
+                if (below(state, 4))
+                    continue;
+                out += ",\"field_";
+                appendNumber(out, key);
+                out += "\":";
+                switch (key % 3) {
+                    case 0: appendNumber(out, below(state, 1000000)); break;
+                    case 1: appendWords(out, state, 1); break;
+                    default: appendDouble(out, double(below(state, 10000)) / 7.0); break;
+                }
+            }
+            out += '}';
+        }
+
+        void deep(std::string& out, size_t index, uint64_t& state, const Options& options)
+        {
+            out += "{\"id\":";
+            appendNumber(out, index);
+            out += ",\"tree\":";
+            // alternate objects and arrays, with a sibling at every level
+            std::string closing;
+            for (size_t level = 0; level < options.depth; ++level) {
+                if (level % 2) {
+                    out += '[';
+                    appendNumber(out, level);
+                    out += ',';
+                    closing += ']';
+                } else {
+                    out += "{\"level\":";
+                    appendNumber(out, level);
+                    out += ",\"name\":";
+                    appendWords(out, state, 1);
+                    out += ",\"child\":";
+                    closing += '}';
+                }
+            }
+            out += "null";
+            out.append(closing.rbegin(), closing.rend());
+            out += '}';
+        }
+
+        void large(std::string& out, size_t index, uint64_t& state, const Options& options)
+        {
+            out += '{';
+            appendKey(out, "id");
+            appendNumber(out, index);
+            out += ',';
+            appendKey(out, "blob");
+            // base64 like text
+            static const char ALPHABET[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+            out += '"';
+            for (size_t i = 0; i < options.stringLength; ++i)
+                out += ALPHABET[below(state, 64)];
+            out += "\",";
+            appendKey(out, "values");
+            out += '[';
+            for (size_t i = 0; i < options.arrayLength; ++i) {
+                if (i)
+                    out += ',';
+                appendNumber(out, below(state, 1000000));
+            }
+            out += "],";
+            appendKey(out, "text");
+            out += '"';
+            for (size_t line = 0; line < 2000; ++line) {
+                out += WORDS[below(state, WORD_COUNT)];
+                out += " lorem ipsum dolor sit amet\\n";
+            }
+            out += "\"}";
+        }
+
+        void escaped(std::string& out, size_t index, uint64_t& state, const Options& options)
+        {
+            out += '{';
+            appendKey(out, "id");
+            appendNumber(out, index);
+            out += ',';
+            appendKey(out, "text");
+            out += '"';
+            const size_t start = out.size();
+            while (out.size() - start < options.stringLength) {
+                if (below(state, 4)) {
+                    out += WORDS[below(state, WORD_COUNT)];
+                    out += ' ';
+                } else {
+                    out += ESCAPED[below(state, ESCAPED_COUNT)];
+                }
+            }
+            out += "\"}";
+        }
+
+        void record(std::string& out, Kind kind, size_t index, uint64_t& state, const Options& options)
+        {
+            switch (kind) {
+                case Kind::Flat: flat(out, index, state); break;
+                case Kind::Log: log(out, index, state); break;
+                case Kind::Nested: nested(out, index, state); break;
+                case Kind::Document: document(out, index, state, options); break;
+                case Kind::Wide: wide(out, index, state, options); break;
+                case Kind::Deep: deep(out, index, state, options); break;
+                case Kind::Large: large(out, index, state, options); break;
+                case Kind::Escaped: escaped(out, index, state, options); break;
+                case Kind::Mixed: {
+                    // mostly small records, big ones now and then
+                    static const Kind SMALL[] = {Kind::Flat, Kind::Log, Kind::Nested, Kind::Wide, Kind::Deep};
+                    static const Kind BIG[] = {Kind::Document, Kind::Large, Kind::Escaped};
+                    Kind pick = below(state, 1000) ? SMALL[below(state, 5)] : BIG[below(state, 3)];
+                    record(out, pick, index, state, options);
+                    break;
+                }
+            }
+        }
+
+        // re-indents a compact record
+        void appendPretty(std::string& out, std::string_view compact)
+        {
+            size_t depth = 0;
+            bool inString = false;
+            auto newline = [&]() {
+                out += '\n';
+                out.append(depth * 2, ' ');
+            };
+
+            for (size_t i = 0; i < compact.size(); ++i) {
+                char c = compact[i];
+                if (inString) {
+                    out += c;
+                    if (c == '\\')
+                        out += compact[++i];
+                    else if (c == '"')
+                        inString = false;
+                    continue;
+                }
+
+                switch (c) {
+                    case '"': inString = true; out += c; break;
+                    case '{': case '[':
+                        out += c;
+                        if (i + 1 < compact.size() && (compact[i + 1] == '}' || compact[i + 1] == ']')) {
+                            out += compact[++i]; // empty container
+                            break;
+                        }
+                        ++depth;
+                        newline();
+                        break;
+                    case '}': case ']': --depth; newline(); out += c; break;
+                    case ',': out += c; newline(); break;
+                    case ':': out += ": "; break;
+                    default: out += c; break;
+                }
+            }
+        }
+
+        size_t typicalBytes(Kind kind, const Options& options)
+        {
+            switch (kind) {
+                case Kind::Flat: return 160;
+                case Kind::Log: return 1024;
+                case Kind::Nested: return 800;
+                case Kind::Document: return options.recordBytes;
+                case Kind::Wide: return options.wideKeys * 12;
+                case Kind::Deep: return options.depth * 24;
+                case Kind::Large: return options.stringLength + options.arrayLength * 7 + 64 * 1024;
+                case Kind::Escaped: return options.stringLength;
+                case Kind::Mixed: return 1024;
+            }
+            return 1024;
+        }
+    }
+
+    std::string_view kindName(Kind kind)
+    {
+        switch (kind) {
+            case Kind::Flat: return "flat";
+            case Kind::Log: return "log";
+            case Kind::Nested: return "nested";
+            case Kind::Document: return "document";
+            case Kind::Wide: return "wide";
+            case Kind::Deep: return "deep";
+            case Kind::Large: return "large";
+            case Kind::Escaped: return "escaped";
+            case Kind::Mixed: return "mixed";
+        }
+        return {};
+    }
+
+    std::optional<Kind> kindFromName(std::string_view name)
+    {
+        for (Kind kind : allKinds()) {
+            if (kindName(kind) == name)
+                return kind;
+        }
+        return std::nullopt;
+    }
+
+    const std::vector<Kind>& allKinds()
+    {
+        static const std::vector<Kind> kinds = {
+            Kind::Flat, Kind::Log, Kind::Nested, Kind::Document, Kind::Wide,
+            Kind::Deep, Kind::Large, Kind::Escaped, Kind::Mixed
+        };
+        return kinds;
+    }
+
+    const std::vector<Kind>& standardKinds()
+    {
+        static const std::vector<Kind> kinds = {Kind::Flat, Kind::Nested, Kind::Wide, Kind::Large};
+        return kinds;
+    }
+
+    std::string_view layoutName(Layout layout)
+    {
+        switch (layout) {
+            case Layout::Lines: return "lines";
+            case Layout::Concatenated: return "concatenated";
+            case Layout::Pretty: return "pretty";
+            case Layout::Mixed: return "mixed";
+        }
+        return {};
+    }
+
+    std::optional<Layout> layoutFromName(std::string_view name)
+    {
+        for (Layout layout : {Layout::Lines, Layout::Concatenated, Layout::Pretty, Layout::Mixed}) {
+            if (layoutName(layout) == name)
+                return layout;
+        }
+        return std::nullopt;
+    }
+
+    size_t defaultRecords(Kind kind, double scale)
+    {
+        // about 20 MB each
+        const size_t records = std::max<size_t>(1, 20 * 1024 * 1024 / typicalBytes(kind, Options{}));
+        return std::max<size_t>(1, static_cast<size_t>(records * scale));
+    }
+
+    size_t chunkRecords(Kind kind, const Options& options)
+    {
+        return std::max<size_t>(1, CHUNK_BYTES / std::max<size_t>(1, typicalBytes(kind, options)));
+    }
+
+    Chunk generateChunk(Kind kind, const Options& options, uint64_t seed, size_t chunk, size_t count)
+    {
+        // every chunk has its own stream, independent of the others
+        uint64_t state = seed ^ (0xd1b54a32d192ed03ULL * (chunk + 1));
+        next(state);
+
+        Chunk result;
+        result.ends.reserve(count);
+        const size_t first = chunk * chunkRecords(kind, options);
+        std::string compact;
+
+        for (size_t i = 0; i < count; ++i) {
+            Layout layout = options.layout;
+            if (layout == Layout::Mixed)
+                layout = static_cast<Layout>(below(state, 3));
+
+            if (layout == Layout::Pretty) {
+                compact.clear();
+                record(compact, kind, first + i, state, options);
+                appendPretty(result.text, compact);
+                result.text += '\n';
+            } else {
+                record(result.text, kind, first + i, state, options);
+                if (layout == Layout::Lines)
+                    result.text += '\n';
+            }
+            result.ends.push_back(result.text.size());
+        }
+        return result;
+    }
+
+    Dataset generate(Kind kind, size_t records, uint64_t seed, const Options& options)
+    {
+        Dataset dataset{kind, std::string(kindName(kind)), {}, records};
+        const size_t perChunk = chunkRecords(kind, options);
+        for (size_t chunk = 0; chunk * perChunk < records; ++chunk) {
+            size_t count = std::min(perChunk, records - chunk * perChunk);
+            dataset.text += generateChunk(kind, options, seed, chunk, count).text;
+        }
+        return dataset;
+    }
+}
@@ -0,0 +1,79 @@
+#pragma once
+
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Deterministic JSONL datasets for benchmarks and scale testing.
+// Records are produced in chunks seeded from the dataset seed and the chunk number,
+// so chunks can be generated in parallel and the same options always give the same bytes.
+namespace synthetic
+{
+    enum class Kind
+    {
+        Flat,     // small records of scalar members
+        Log,      // log lines of about 1 KB
+        Nested,   // objects and arrays a few levels deep
+        Document, // nested records grown to Options::recordBytes
+        Wide,     // Options::wideKeys top level keys, sparse across records
+        Deep,     // containers nested Options::depth levels
+        Large,    // long strings and arrays of Options::arrayLength numbers
+        Escaped,  // strings of Options::stringLength full of escapes and unicode
+        Mixed,    // any of the above per record
+    };
+
+    // how records follow each other
+    enum class Layout
+    {
+        Lines,        // NDJSON, one record per line
+        Concatenated, // records back to back, no separator
+        Pretty,       // indented records over many lines
+        Mixed,        // any of the above per record
+    };
+
+    struct Options
+    {
+        Layout layout = Layout::Lines;
+        size_t wideKeys = 400;
+        size_t depth = 64;
+        size_t arrayLength = 100000;
+        size_t stringLength = 1024 * 1024;
+        size_t recordBytes = 5 * 1024 * 1024;
+    };
+
+    struct Dataset
+    {
+        Kind kind;
+        std::string name;
+        std::string text;
+        size_t records = 0;
+    };
+
+    // a chunk of consecutive records and where each of them ends in `text`
+    struct Chunk
+    {
+        std::string text;
+        std::vector<size_t> ends;
+    };
+
+    std::string_view kindName(Kind kind);
+    std::optional<Kind> kindFromName(std::string_view name);
+    const std::vector<Kind>& allKinds();
+    // datasets measured by JsonViewBench
+    const std::vector<Kind>& standardKinds();
+
+    std::string_view layoutName(Layout layout);
+    std::optional<Layout> layoutFromName(std::string_view name);
+
+    // records of a typical dataset of the kind, scaled by `scale`
+    size_t defaultRecords(Kind kind, double scale = 1.0);
+
+    // records in every chunk, chosen so a chunk is a few MB
+    size_t chunkRecords(Kind kind, const Options& options);
+    // records [chunk * chunkRecords, +count) of the dataset
+    Chunk generateChunk(Kind kind, const Options& options, uint64_t seed, size_t chunk, size_t count);
+
+    Dataset generate(Kind kind, size_t records, uint64_t seed = 1, const Options& options = {});
+}
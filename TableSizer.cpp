@@ -0,0 +1,120 @@
+#include "TableSizer.h"
+#include "constants.h"
+
+#include <QHeaderView>
+#include <QFontMetrics>
+
+#include <algorithm>
+#include <random>
+
+namespace
+{
+    // only the beginning of a cell is visible in a column of MAX_COLUMN_WIDTH
+    constexpr int MEASURED_CHARS = 200;
+    constexpr int CELL_MARGIN = 12;
+}
+
+TableSizer::TableSizer(QTableView* view, QObject* parent)
+    : QObject(parent), m_view(view)
+{
+    // Qt's own resize to contents (header handle double click) looks at visible rows only
+    m_view->horizontalHeader()->setResizeContentsPrecision(0);
+    connect(m_view->horizontalHeader(), &QHeaderView::sectionHandleDoubleClicked, this, [this](int column) {
+        resizeColumns(column, column);
+    });
+
+    updateRowHeight();
+    attach(m_view->model());
+}
+
+void TableSizer::attach(QAbstractItemModel* model)
+{
+    if (!model)
+        return;
+
+    connect(model, &QAbstractItemModel::modelReset, this, [this]() { resizeColumns(); });
+    connect(model, &QAbstractItemModel::columnsInserted, this, [this](const QModelIndex&, int first, int last) {
+        resizeColumns(first, last);
+    });
+}
+
+void TableSizer::updateRowHeight()
+{
+    // single line rows, all of the same height, so nothing has to be measured
+    auto* header = m_view->verticalHeader();
+    header->setSectionResizeMode(QHeaderView::Fixed);
+    header->setDefaultSectionSize(QFontMetrics(m_view->font()).lineSpacing() + CELL_MARGIN / 2);
+}
+
+std::vector<int> TableSizer::sampleRows(int rowCount, int sampleSize)
+{
+    std::vector<int> rows;
+    if (rowCount <= 0)
+        return rows;
+
+    if (rowCount <= sampleSize) {
+        rows.resize(rowCount);
+        for (int i = 0; i < rowCount; ++i)
+            rows[i] = i;
+        return rows;
+    }
+
+    // a quarter from each end, the rest spread over the file
+    const int edge = sampleSize / 4;
+    rows.reserve(sampleSize);
+    for (int i = 0; i < edge; ++i) {
+        rows.push_back(i);
+        rows.push_back(rowCount - 1 - i);
+    }
+
+    // same file, same sample, so widths don't jump between reloads
+    std::mt19937 random(static_cast<uint32_t>(rowCount));
+    const int spread = sampleSize - 2 * edge;
+    const double stride = double(rowCount) / spread;
+    for (int i = 0; i < spread; ++i) {
+        std::uniform_int_distribution<int> offset(0, std::max(0, int(stride) - 1));
+        rows.push_back(std::min(rowCount - 1, int(i * stride) + offset(random)));
+    }
+
+    std::sort(rows.begin(), rows.end());
+    rows.erase(std::unique(rows.begin(), rows.end()), rows.end());
+    return rows;
+}
+
+int TableSizer::measureColumn(int column, const std::vector<int>& rows) const
+{
+    auto* model = m_view->model();
+    QFontMetrics metrics(m_view->font());
+
+    QString title = model->headerData(column, Qt::Horizontal, Qt::DisplayRole).toString();
+    int width = metrics.horizontalAdvance(title) + 2 * CELL_MARGIN;
+
+    for (int row : rows) {
+        QString text = model->data(model->index(row, column), Qt::DisplayRole).toString();
+        int newline = text.indexOf('\n');
+        int length = std::min(newline < 0 ? int(text.size()) : newline, MEASURED_CHARS);
+        width = std::max(width, metrics.horizontalAdvance(text.left(length)) + CELL_MARGIN);
+        if (width >= MAX_COLUMN_WIDTH)
+            break;
+    }
+
+    return std::min(width, MAX_COLUMN_WIDTH);
+}
+
+void TableSizer::resizeColumns()
+{
+    if (auto* model = m_view->model())
+        resizeColumns(0, model->columnCount() - 1);
+}
+
+void TableSizer::resizeColumns(int first, int last)
+{
+    auto* model = m_view->model();
+    if (!model || first > last)
+        return;
+
+    const auto rows = sampleRows(model->rowCount(), SIZE_SAMPLE_ROWS);
+    auto* header = m_view->horizontalHeader();
+    for (int column = first; column <= last; ++column)
+        header->resizeSection(column, measureColumn(column, rows));
+}
@@ -0,0 +1,30 @@
+#pragma once
+
+#include <QObject>
+#include <QTableView>
+
+#include <vector>
+
+// Sizes table columns from a bounded sample of rows instead of measuring all of them,
+// so the cost doesn't grow with the file. Columns are sized on model reset and when
+// new columns are discovered, rows get a fixed height derived from the font.
+class TableSizer : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit TableSizer(QTableView* view, QObject* parent = nullptr);
+
+    void resizeColumns();
+    void resizeColumns(int first, int last);
+
+    // head, tail and evenly spread pseudo random rows, sorted and unique
+    static std::vector<int> sampleRows(int rowCount, int sampleSize);
+
+private:
+    QTableView* m_view;
+
+    void attach(QAbstractItemModel* model);
+    void updateRowHeight();
+    int measureColumn(int column, const std::vector<int>& rows) const;
+};
@@ -0,0 +1,223 @@
+#include "TreeModelLoader.h"
+#include "constants.h"
+
+#include <QtConcurrent/QtConcurrent>
+
+#include <algorithm>
+#include <iterator>
+
+TreeModelLoader::TreeModelLoader(JsonFile* jsonFile, QTreeView* treeView, QObject* parent)
+    : QObject(parent), m_jsonFile(jsonFile), m_treeView(treeView)
+{
+    m_timer.setSingleShot(true);
+    m_timer.setInterval(TREE_LOAD_DELAY_MS);
+
+    connect(&m_timer, &QTimer::timeout, this, &TreeModelLoader::load);
+    connect(&m_watcher, &QFutureWatcher<JsonTreeModel*>::finished, this, &TreeModelLoader::onLoaded);
+}
+
+TreeModelLoader::~TreeModelLoader()
+{
+    clear();
+}
+
+void TreeModelLoader::request(int row)
+{
+    m_requestedRow = row;
+
+    // recent records are shown right away
+    auto it = find(row);
+    if (it != m_cache.end()) {
+        m_timer.stop();
+        show(it);
+        return;
+    }
+
+    m_timer.start();
+}
+
+void TreeModelLoader::clear()
+{
+    m_timer.stop();
+
+    // the worker reads the mapped file, let it finish before the file goes away
+    if (m_loadingRow >= 0) {
+        m_future.waitForFinished();
+        delete m_future.result();
+        m_loadingRow = -1;
+    }
+
+    if (m_treeView) {
+        auto* selectionModel = m_treeView->selectionModel();
+        m_treeView->setModel(nullptr);
+        delete selectionModel;
+    }
+
+    for (auto& entry : m_cache)
+        delete entry.model;
+
+    m_cache.clear();
+    m_requestedRow = -1;
+    m_shownRow = -1;
+}
+
+void TreeModelLoader::load()
+{
+    // one build at a time, the latest request is picked up when it finishes
+    if (m_loadingRow >= 0)
+        return;
+
+    const int row = m_requestedRow;
+    if (row < 0 || row == m_shownRow)
+        return;
+
+    auto it = find(row);
+    if (it != m_cache.end()) {
+        show(it);
+        return;
+    }
+
+    const JsonFile* jsonFile = m_jsonFile;
+    const size_t bucketSize = m_bucketSize;
+    QThread* target = thread();
+
+    m_loadingRow = row;
+    m_future = QtConcurrent::run([jsonFile, row, bucketSize, target]() {
+        // a huge record would need several times its size as a DOM, it's indexed instead
+        const auto text = jsonFile->lineText(row);
+        if (text.size() > LAZY_DOCUMENT_BYTES) {
+            auto structure = std::make_unique<StructuralIndex>(text);
+            if (structure->valid()) {
+                auto* model = new JsonTreeModel(std::move(structure), bucketSize);
+                model->rowCount(QModelIndex());
+                model->moveToThread(target);
+                return model;
+            }
+        }
+
+        auto doc = std::make_unique<rapidjson::Document>();
+        std::vector<JsonSpan> spans;
+        jsonFile->parseLine(row, *doc, spans);
+
+        auto* model = new JsonTreeModel(std::move(doc), std::move(spans), text, bucketSize);
+        model->rowCount(QModelIndex()); // prepare the first level here as well
+        model->moveToThread(target);
+        return model;
+    });
+    m_watcher.setFuture(m_future);
+}
+
+void TreeModelLoader::onLoaded()
+{
+    if (m_loadingRow < 0) // cleared meanwhile
+        return;
+
+    const int row = m_loadingRow;
+    m_loadingRow = -1;
+    insert(row, m_future.result());
+
+    if (row == m_requestedRow)
+        show(find(row));
+    else
+        load(); // selection moved on while building
+}
+
+void TreeModelLoader::show(Iterator entry)
+{
+    if (!m_treeView || entry->row == m_shownRow)
+        return;
+
+    auto shown = find(m_shownRow);
+    if (shown != m_cache.end())
+        saveState(*shown);
+
+    auto* selectionModel = m_treeView->selectionModel();
+    m_treeView->setModel(entry->model);
+    delete selectionModel;
+
+    for (const auto& index : entry->expanded) {
+        if (index.isValid())
+            m_treeView->expand(index);
+    }
+
+    if (entry->current.isValid()) {
+        m_treeView->setCurrentIndex(entry->current);
+        m_treeView->scrollTo(entry->current);
+    }
+
+    m_shownRow = entry->row;
+    m_cache.splice(m_cache.begin(), m_cache, entry);
+
+    emit modelChanged(entry->model);
+}
+
+void TreeModelLoader::saveState(Entry& entry)
+{
+    if (m_treeView->model() != entry.model)
+        return;
+
+    entry.expanded.clear();
+    collectExpanded(QModelIndex(), entry.expanded);
+    entry.current = m_treeView->currentIndex();
+}
+
+void TreeModelLoader::collectExpanded(const QModelIndex& parent, QList<QPersistentModelIndex>& expanded) const
+{
+    auto* model = m_treeView->model();
+    const int rows = model->rowCount(parent);
+
+    for (int row = 0; row < rows; ++row) {
+        QModelIndex index = model->index(row, 0, parent);
+        if (m_treeView->isExpanded(index)) {
+            expanded.append(index);
+            collectExpanded(index, expanded);
+        }
+    }
+}
+
+TreeModelLoader::Iterator TreeModelLoader::find(int row)
+{
+    return std::find_if(m_cache.begin(), m_cache.end(), [row](const Entry& entry) {
+        return entry.row == row;
+    });
+}
+
+size_t TreeModelLoader::memoryUsage() const
+{
+    size_t bytes = 0;
+    for (const auto& entry : m_cache)
+        bytes += entry.model->memoryUsage();
+    return bytes;
+}
+
+void TreeModelLoader::trim(size_t target)
+{
+    size_t bytes = memoryUsage();
+    auto it = m_cache.end();
+    while (bytes > target && it != m_cache.begin()) {
+        auto victim = --it;
+        if (victim->row == m_shownRow)
+            continue;
+
+        bytes -= victim->model->memoryUsage();
+        it = std::next(victim);
+        delete victim->model;
+        m_cache.erase(victim);
+    }
+}
+
+void TreeModelLoader::insert(int row, JsonTreeModel* model)
+{
+    m_cache.push_front(Entry{row, model, {}, {}});
+
+    // evict least recently used models, except the one on screen
+    auto it = std::prev(m_cache.end());
+    while (m_cache.size() > TREE_MODEL_CACHE_SIZE && it != m_cache.begin()) {
+        auto victim = it--;
+        if (victim->row == m_shownRow)
+            continue;
+
+        delete victim->model;
+        m_cache.erase(victim);
+    }
+}
@@ -0,0 +1,71 @@
+#pragma once
+
+#include "JsonFile.h"
+#include "JsonTreeModel.h"
+
+#include <QObject>
+#include <QTimer>
+#include <QTreeView>
+#include <QPointer>
+#include <QFuture>
+#include <QFutureWatcher>
+#include <QPersistentModelIndex>
+
+#include <list>
+
+// Builds tree models for table rows on a worker thread. Row changes are debounced
+// and recently shown models are kept together with their expansion state.
+class TreeModelLoader : public QObject
+{
+    Q_OBJECT
+
+public:
+    TreeModelLoader(JsonFile* jsonFile, QTreeView* treeView, QObject* parent = nullptr);
+    ~TreeModelLoader() override;
+
+    void request(int row);
+    // drop models and pending work referring to the current file
+    void clear();
+
+    void setBucketSize(size_t bucketSize) { m_bucketSize = bucketSize; }
+
+    // memory of the cached models
+    size_t memoryUsage() const;
+    // drop least recently used models, except the one on screen, down to `target` bytes
+    void trim(size_t target);
+
+signals:
+    void modelChanged(JsonTreeModel* model);
+
+private:
+    struct Entry
+    {
+        int row;
+        JsonTreeModel* model;
+        QList<QPersistentModelIndex> expanded;
+        QPersistentModelIndex current;
+    };
+    using Iterator = std::list<Entry>::iterator;
+
+    JsonFile* m_jsonFile;
+    QPointer<QTreeView> m_treeView;
+    size_t m_bucketSize = TREE_BUCKET_SIZE;
+
+    QTimer m_timer;
+    int m_requestedRow = -1;
+    int m_loadingRow = -1;
+    int m_shownRow = -1;
+
+    QFuture<JsonTreeModel*> m_future;
+    QFutureWatcher<JsonTreeModel*> m_watcher;
+
+    std::list<Entry> m_cache; // most recently used first
+
+    void load();
+    void onLoaded();
+    void show(Iterator entry);
+    void saveState(Entry& entry);
+    void collectExpanded(const QModelIndex& parent, QList<QPersistentModelIndex>& expanded) const;
+    Iterator find(int row);
+    void insert(int row, JsonTreeModel* model);
+};
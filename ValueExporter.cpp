@@ -0,0 +1,240 @@
+#include "ValueExporter.h"
+
+#include <rapidjson/writer.h>
+#include <rapidjson/prettywriter.h>
+#include <rapidjson/reader.h>
+#include <rapidjson/memorystream.h>
+
+#include <QFile>
+
+#include <algorithm>
+
+namespace
+{
+    const size_t STREAM_BUFFER = 256 * 1024;
+
+    // buffered output for rapidjson writers, full buffers go to the sink
+    class SinkStream
+    {
+    public:
+        typedef char Ch;
+
+        explicit SinkStream(const std::function<bool(const char*, size_t)>& sink) : _sink(sink), _failed(false)
+        {
+            _buffer.reserve(STREAM_BUFFER);
+        }
+
+        void Put(char c)
+        {
+            _buffer.push_back(c);
+            if (_buffer.size() >= STREAM_BUFFER)
+                Flush();
+        }
+
+        void Flush()
+        {
+            if (!_buffer.empty() && !_failed)
+                _failed = !_sink(_buffer.data(), _buffer.size());
+            _buffer.clear();
+        }
+
+        bool failed() const { return _failed; }
+
+    private:
+        const std::function<bool(const char*, size_t)>& _sink;
+        bool _failed;
+        std::string _buffer;
+    };
+
+    // stops Accept once the sink failed or the work was canceled
+    template <typename Writer>
+    class StoppableWriter
+    {
+    public:
+        typedef char Ch;
+        using SizeType = rapidjson::SizeType;
+
+        explicit StoppableWriter(SinkStream& stream) : _stream(stream), _writer(stream)
+        {
+        }
+
+        bool Null() { return _writer.Null() && more(); }
+        bool Bool(bool b) { return _writer.Bool(b) && more(); }
+        bool Int(int i) { return _writer.Int(i) && more(); }
+        bool Uint(unsigned i) { return _writer.Uint(i) && more(); }
+        bool Int64(int64_t i) { return _writer.Int64(i) && more(); }
+        bool Uint64(uint64_t i) { return _writer.Uint64(i) && more(); }
+        bool Double(double d) { return _writer.Double(d) && more(); }
+        bool RawNumber(const Ch* str, SizeType length, bool copy) { return _writer.RawNumber(str, length, copy) && more(); }
+        bool String(const Ch* str, SizeType length, bool copy) { return _writer.String(str, length, copy) && more(); }
+        bool Key(const Ch* str, SizeType length, bool copy) { return _writer.Key(str, length, copy) && more(); }
+        bool StartObject() { return _writer.StartObject() && more(); }
+        bool EndObject(SizeType memberCount) { return _writer.EndObject(memberCount) && more(); }
+        bool StartArray() { return _writer.StartArray() && more(); }
+        bool EndArray(SizeType elementCount) { return _writer.EndArray(elementCount) && more(); }
+
+    private:
+        SinkStream& _stream;
+        Writer _writer;
+
+        bool more() const { return !_stream.failed(); }
+    };
+
+    // takes the text of a string read from its source
+    struct StringText : rapidjson::BaseReaderHandler<rapidjson::UTF8<>, StringText>
+    {
+        const std::function<bool(const char*, size_t)>& sink;
+        bool written = false;
+
+        explicit StringText(const std::function<bool(const char*, size_t)>& sink) : sink(sink) {}
+
+        bool String(const char* str, rapidjson::SizeType length, bool);
+        bool Default() { return false; }
+    };
+
+    // copies large blocks in steps, so canceling is noticed
+    bool writeChunked(const char* data, size_t size, const std::function<bool(const char*, size_t)>& sink)
+    {
+        for (size_t offset = 0; offset < size; offset += STREAM_BUFFER) {
+            if (!sink(data + offset, std::min(STREAM_BUFFER, size - offset)))
+                return false;
+        }
+        return true;
+    }
+
+    bool StringText::String(const char* str, rapidjson::SizeType length, bool)
+    {
+        written = writeChunked(str, length, sink);
+        return written;
+    }
+}
+
+ValueExporter::ValueExporter(std::shared_ptr<const rapidjson::Document> owner, const rapidjson::Value* value, std::string_view source)
+    : m_owner(std::move(owner)), m_value(value), m_source(source)
+{
+}
+
+size_t ValueExporter::sizeHint() const
+{
+    if (m_value && m_value->IsString())
+        return m_value->GetStringLength();
+    return m_source.size();
+}
+
+bool ValueExporter::write(Format format, const Sink& sink) const
+{
+    if (format == Format::Raw && !m_source.empty())
+        return writeChunked(m_source.data(), m_source.size(), sink);
+
+    if (!m_value) {
+        // SAX from the source straight to the writer, no DOM of the value is built
+        SinkStream stream(sink);
+        rapidjson::Reader reader;
+        rapidjson::MemoryStream source(m_source.data(), m_source.size());
+        bool ok = false;
+        if (!m_source.empty() && m_source.front() == '"') {
+            // strings are copied as their text here as well
+            StringText handler(sink);
+            reader.Parse(source, handler);
+            return handler.written;
+        } else if (format == Format::Pretty) {
+            StoppableWriter<rapidjson::PrettyWriter<SinkStream>> writer(stream);
+            ok = !reader.Parse(source, writer).IsError();
+        } else {
+            StoppableWriter<rapidjson::Writer<SinkStream>> writer(stream);
+            ok = !reader.Parse(source, writer).IsError();
+        }
+        stream.Flush();
+        return ok && !stream.failed();
+    }
+
+    // strings are copied as their text, not as a JSON string
+    if (format != Format::Raw && m_value->IsString())
+        return writeChunked(m_value->GetString(), m_value->GetStringLength(), sink);
+
+    SinkStream stream(sink);
+    if (format == Format::Pretty) {
+        StoppableWriter<rapidjson::PrettyWriter<SinkStream>> writer(stream);
+        m_value->Accept(writer);
+    } else {
+        StoppableWriter<rapidjson::Writer<SinkStream>> writer(stream);
+        m_value->Accept(writer);
+    }
+    stream.Flush();
+    return !stream.failed();
+}
+
+QByteArray ValueExporter::toBytes(Format format, const Proceed& proceed) const
+{
+    QByteArray result;
+    result.reserve(static_cast<qsizetype>(sizeHint()));
+
+    bool ok = write(format, [&](const char* data, size_t size) {
+        result.append(data, static_cast<qsizetype>(size));
+        return proceed();
+    });
+    return ok ? result : QByteArray();
+}
+
+bool ValueExporter::save(const QString& path, Format format, const Proceed& proceed, QString* error) const
+{
+    QFile file(path);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate | QIODevice::Unbuffered)) {
+        if (error)
+            *error = QString("%1: %2").arg(path, file.errorString());
+        return false;
+    }
+
+    bool canceled = false;
+    bool ok = write(format, [&](const char* data, size_t size) {
+        if (!proceed()) {
+            canceled = true;
+            return false;
+        }
+        return file.write(data, static_cast<qint64>(size)) == static_cast<qint64>(size);
+    });
+
+    if (!ok) {
+        if (error)
+            *error = canceled ? QString("Canceled") : QString("%1: %2").arg(path, file.errorString());
+        file.close();
+        file.remove();
+        return false;
+    }
+    return true;
+}
+
+FutureMimeData::FutureMimeData(QFuture<QByteArray> future)
+    : m_future(std::move(future))
+{
+}
+
+FutureMimeData::~FutureMimeData()
+{
+    // replaced on the clipboard before it was done
+    m_future.cancel();
+}
+
+QStringList FutureMimeData::formats() const
+{
+    return {"text/plain;charset=utf-8", "text/plain"};
+}
+
+bool FutureMimeData::hasFormat(const QString& mimeType) const
+{
+    return formats().contains(mimeType);
+}
+
+QVariant FutureMimeData::retrieveData(const QString& mimeType, QMetaType type) const
+{
+    Q_UNUSED(type);
+    if (!hasFormat(mimeType))
+        return QVariant();
+
+    m_future.waitForFinished();
+    if (m_future.isCanceled() || m_future.resultCount() == 0)
+        return QVariant();
+
+    // implicitly shared, no copy
+    return m_future.result();
+}
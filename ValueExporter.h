@@ -0,0 +1,69 @@
+#pragma once
+
+#include <rapidjson/document.h>
+
+#include <QByteArray>
+#include <QFuture>
+#include <QMimeData>
+#include <QString>
+
+#include <functional>
+#include <memory>
+#include <string_view>
+
+// Serializes one value of a tree for the clipboard or a file, meant to run on a
+// worker thread. Raw output copies the source bytes, the other formats stream
+// through rapidjson in fixed size chunks, so the value is never held as a QString.
+class ValueExporter
+{
+public:
+    enum class Format
+    {
+        Raw,        // source bytes, minified when there is no source
+        Minified,   // strings as their text, other values as JSON
+        Pretty,
+    };
+
+    // returns false to cancel
+    using Proceed = std::function<bool()>;
+
+    // `owner` keeps `value` alive, `source` must stay valid while writing.
+    // Without a value the source is reformatted as it's read, for items of lazy tree models.
+    ValueExporter(std::shared_ptr<const rapidjson::Document> owner, const rapidjson::Value* value, std::string_view source);
+
+    // empty when canceled
+    QByteArray toBytes(Format format, const Proceed& proceed) const;
+    bool save(const QString& path, Format format, const Proceed& proceed, QString* error) const;
+
+    // bytes of raw output, a guess for the other formats
+    size_t sizeHint() const;
+
+private:
+    using Sink = std::function<bool(const char* data, size_t size)>;
+
+    std::shared_ptr<const rapidjson::Document> m_owner;
+    const rapidjson::Value* m_value;
+    std::string_view m_source;
+
+    bool write(Format format, const Sink& sink) const;
+};
+
+// Clipboard data that is still being produced. The bytes are taken from the future
+// when they're pasted, pasting before it finished waits for it.
+class FutureMimeData : public QMimeData
+{
+    Q_OBJECT
+
+public:
+    explicit FutureMimeData(QFuture<QByteArray> future);
+    ~FutureMimeData() override;
+
+    QStringList formats() const override;
+    bool hasFormat(const QString& mimeType) const override;
+
+protected:
+    QVariant retrieveData(const QString& mimeType, QMetaType type) const override;
+
+private:
+    mutable QFuture<QByteArray> m_future;
+};
@@ -12,3 +12,24 @@ enum TreeViewColumn : int
 };
 
 const std::size_t MAX_JSON_STRING_LENGTH = 1024; // 1 KB
+const std::size_t TREE_BUCKET_SIZE = 1000; // children per range group in the tree view
+const int TREE_LOAD_DELAY_MS = 50; // debounce of table row changes before a tree is built
+const std::size_t TREE_MODEL_CACHE_SIZE = 8; // recently shown tree models kept alive
+const std::size_t CELL_CACHE_BUDGET = 32 * 1024 * 1024; // memory for formatted table cells
+const std::size_t GROUP_BY_MEMORY_BUDGET = 64 * 1024 * 1024; // bytes of groups and digests before the rest is folded into "(other)"
+const std::size_t GROUP_BY_MAX_ROWS = 1000; // row numbers remembered per group for navigation
+const std::size_t GROUP_BY_ROWS_BUDGET = 16 * 1024 * 1024; // bytes of remembered row numbers of all groups, never folds groups
+const std::size_t ASYNC_PARSE_THRESHOLD = 256 * 1024; // table records larger than this are parsed in background
+const int MAX_CELL_LINES = 20; // tallest multiline cell in the tree view
+const int SIZE_SAMPLE_ROWS = 128; // rows measured when sizing table columns
+const int MAX_COLUMN_WIDTH = 400; // widest automatically sized table column
+const std::size_t LARGE_STRING_LENGTH = 256 * 1024; // strings shown through LargeTextView instead of a copy
+const std::size_t LARGE_STRING_PREVIEW = 16 * 1024; // bytes of a large string shown in its cell
+const double MEMORY_BUDGET_SHARE = 0.5; // default cache budget, part of the physical or cgroup memory
+const int MEMORY_CHECK_INTERVAL_MS = 1000; // how often the caches are compared to the budget
+const double MEMORY_LOW_WATERMARK = 0.8; // part of the budget kept when shrinking caches over budget
+const double MEMORY_PRESSURE_SHRINK = 0.5; // part of the caches kept on kernel memory pressure
+const std::size_t ASYNC_COPY_THRESHOLD = 1024 * 1024; // values larger than this are copied and saved on a worker thread
+const std::size_t RAW_WINDOW_BYTES = 4 * 1024 * 1024; // file bytes shown around the record in the raw view
+const std::size_t LAZY_DOCUMENT_BYTES = 64 * 1024 * 1024; // records larger than this are browsed through a StructuralIndex, not a DOM
+const std::size_t STRUCTURAL_INDEX_MIN_BYTES = 16 * 1024; // smaller containers are parsed when expanded instead of indexed
@@ -3,6 +3,12 @@
 #include <rapidjson/stringbuffer.h>
 #include <rapidjson/prettywriter.h>
 #include <rapidjson/writer.h>
+#include <rapidjson/reader.h>
+#include <rapidjson/memorystream.h>
+
+#include <algorithm>
+#include <cctype>
+#include <cstring>
 
 class TruncatingStream {
 public:
@@ -38,6 +44,8 @@ public:
 
     const std::string& str() const { return _buffer; }
     bool overflown() const { return _overflown; }
+    void setOverflown() { _overflown = true; }
+    size_t room() const { return _limit - _buffer.size(); }
 
 private:
     size_t _limit;
@@ -80,10 +88,59 @@ private:
 //     return truncatingStream.size();
 // }
 
+// Writer that stops the traversal once the stream is full.
+// Handlers returning false make Value::Accept return immediately, so the
+// cost is bounded by the limit rather than by the size of the value.
+class TruncatingWriter
+{
+public:
+    typedef char Ch;
+    using SizeType = rapidjson::SizeType;
+
+    TruncatingWriter(TruncatingStream& stream) : _stream(stream), _writer(stream)
+    {
+    }
+
+    bool Null() { return _writer.Null() && more(); }
+    bool Bool(bool b) { return _writer.Bool(b) && more(); }
+    bool Int(int i) { return _writer.Int(i) && more(); }
+    bool Uint(unsigned i) { return _writer.Uint(i) && more(); }
+    bool Int64(int64_t i) { return _writer.Int64(i) && more(); }
+    bool Uint64(uint64_t i) { return _writer.Uint64(i) && more(); }
+    bool Double(double d) { return _writer.Double(d) && more(); }
+    bool RawNumber(const Ch* str, SizeType length, bool copy) { return _writer.RawNumber(str, length, copy) && more(); }
+    bool String(const Ch* str, SizeType length, bool copy) { return _writer.String(str, cut(str, length), copy) && more(); }
+    bool Key(const Ch* str, SizeType length, bool copy) { return _writer.Key(str, cut(str, length), copy) && more(); }
+    bool StartObject() { return _writer.StartObject() && more(); }
+    bool EndObject(SizeType memberCount) { return _writer.EndObject(memberCount) && more(); }
+    bool StartArray() { return _writer.StartArray() && more(); }
+    bool EndArray(SizeType elementCount) { return _writer.EndArray(elementCount) && more(); }
+
+private:
+    TruncatingStream& _stream;
+    rapidjson::Writer<TruncatingStream> _writer;
+
+    bool more() const { return !_stream.overflown(); }
+
+    // a long string is written only up to the space left, escaping makes it longer anyway
+    SizeType cut(const Ch* str, SizeType length)
+    {
+        size_t room = _stream.room();
+        if (length <= room)
+            return length;
+
+        // don't split a utf-8 sequence
+        while (room > 0 && (static_cast<unsigned char>(str[room]) & 0xC0) == 0x80)
+            --room;
+        _stream.setOverflown();
+        return static_cast<SizeType>(room);
+    }
+};
+
 std::string toJsonString(const rapidjson::Value& value, size_t limit) {
 
     TruncatingStream truncatingStream(limit);
-    rapidjson::Writer<TruncatingStream> writer(truncatingStream);
+    TruncatingWriter writer(truncatingStream);
     value.Accept(writer);
 
     std::string result = truncatingStream.str();
@@ -93,6 +150,22 @@ std::string toJsonString(const rapidjson::Value& value, size_t limit) {
     return result;
 }
 
+std::string toJsonString(std::string_view text, size_t limit) {
+    // a few times the output is enough input, a long string is cut short there
+    const size_t input = std::min(text.size(), limit * 8);
+    TruncatingStream truncatingStream(limit);
+    TruncatingWriter writer(truncatingStream);
+    rapidjson::Reader reader;
+    rapidjson::MemoryStream stream(text.data(), input);
+    reader.Parse<rapidjson::kParseStopWhenDoneFlag>(stream, writer);
+
+    std::string result = truncatingStream.str();
+    if (truncatingStream.overflown() || input < text.size()) {
+        result += ">>>";
+    }
+    return result;
+}
+
 std::string toJsonString(const rapidjson::Value& value) {
     rapidjson::StringBuffer buffer;
     rapidjson::Writer<rapidjson::StringBuffer> writer(buffer);
@@ -101,6 +174,103 @@ std::string toJsonString(const rapidjson::Value& value) {
     return std::string(buffer.GetString(), buffer.GetSize());
 }
 
+namespace
+{
+    // forwards SAX events to the document and records where every value lives in the source
+    class SpanRecorder
+    {
+    public:
+        typedef char Ch;
+
+        SpanRecorder(rapidjson::Document& doc, const rapidjson::MemoryStream& stream, std::vector<JsonSpan>& spans)
+            : _doc(doc), _stream(stream), _spans(spans), _cursor(0)
+        {
+        }
+
+        bool Null() { scalar(); return _doc.Null(); }
+        bool Bool(bool b) { scalar(); return _doc.Bool(b); }
+        bool Int(int i) { scalar(); return _doc.Int(i); }
+        bool Uint(unsigned i) { scalar(); return _doc.Uint(i); }
+        bool Int64(int64_t i) { scalar(); return _doc.Int64(i); }
+        bool Uint64(uint64_t i) { scalar(); return _doc.Uint64(i); }
+        bool Double(double d) { scalar(); return _doc.Double(d); }
+        bool RawNumber(const Ch* str, rapidjson::SizeType length, bool copy) { scalar(); return _doc.RawNumber(str, length, copy); }
+        bool String(const Ch* str, rapidjson::SizeType length, bool copy) { scalar(); return _doc.String(str, length, copy); }
+
+        bool Key(const Ch* str, rapidjson::SizeType length, bool copy)
+        {
+            _cursor = _stream.Tell();
+            return _doc.Key(str, length, copy);
+        }
+
+        bool StartObject() { open(); return _doc.StartObject(); }
+        bool EndObject(rapidjson::SizeType memberCount) { close(); return _doc.EndObject(memberCount); }
+        bool StartArray() { open(); return _doc.StartArray(); }
+        bool EndArray(rapidjson::SizeType elementCount) { close(); return _doc.EndArray(elementCount); }
+
+    private:
+        rapidjson::Document& _doc;
+        const rapidjson::MemoryStream& _stream;
+        std::vector<JsonSpan>& _spans;
+        std::vector<size_t> _open;
+        size_t _cursor; // position right after the last event
+
+        // events are delivered after the value is consumed, so the start of a
+        // scalar is found by skipping separators following the previous event
+        size_t valueStart() const
+        {
+            const char* p = _stream.begin_ + _cursor;
+            while (p < _stream.end_ && (std::isspace(static_cast<unsigned char>(*p)) || *p == ':' || *p == ','))
+                ++p;
+            return p - _stream.begin_;
+        }
+
+        void scalar()
+        {
+            size_t start = valueStart();
+            _cursor = _stream.Tell();
+            _spans.push_back(JsonSpan{start, _cursor - start, 0});
+        }
+
+        void open()
+        {
+            // the opening bracket is already taken
+            _cursor = _stream.Tell();
+            _open.push_back(_spans.size());
+            _spans.push_back(JsonSpan{_cursor - 1, 0, 0});
+        }
+
+        void close()
+        {
+            _cursor = _stream.Tell();
+            size_t index = _open.back();
+            _open.pop_back();
+            auto& span = _spans[index];
+            span.length = _cursor - span.offset;
+            span.descendants = _spans.size() - index - 1;
+        }
+    };
+}
+
+bool parseWithSpans(std::string_view text, rapidjson::Document& doc, std::vector<JsonSpan>& spans)
+{
+    spans.clear();
+
+    rapidjson::MemoryStream stream(text.data(), text.size());
+    bool ok = false;
+    auto generator = [&](rapidjson::Document& target) {
+        SpanRecorder recorder(target, stream, spans);
+        rapidjson::Reader reader;
+        ok = !reader.Parse(stream, recorder).IsError();
+        return ok;
+    };
+    doc.Populate(generator);
+
+    if (!ok)
+        spans.clear();
+    return ok;
+}
+
 std::optional<Range> matchJsonValue(const char* input, size_t length) {
     const char* p = input;
     const char* end = input + length;
@@ -230,6 +400,226 @@ void parseSequentialJson(std::string_view data, std::function<void(size_t, std::
     // return results;
 }
 
+size_t nextRecordStart(std::string_view data, size_t from)
+{
+    while (from < data.size()) {
+        size_t newline = data.find('\n', from);
+        if (newline == std::string_view::npos || newline + 1 >= data.size())
+            break;
+        if (data[newline + 1] == '{' || data[newline + 1] == '[')
+            return newline + 1;
+        from = newline + 1;
+    }
+    return data.size();
+}
+
+void indexSequentialJson(std::string_view data, std::function<void(size_t, std::string_view)> consumer,
+                         std::function<void(size_t, size_t)> skipped)
+{
+    const char* begin = data.data();
+    const char* p = begin;
+    const char* end = p + data.size();
+    size_t index = 0;
+
+    // after the first error values are only matched up to the next record start, a broken
+    // record would otherwise swallow the ones following it
+    bool bounded = false;
+
+    while (p < end) {
+        while (p < end && std::isspace(static_cast<unsigned char>(*p)))
+            ++p;
+        if (p == end)
+            break;
+
+        const size_t offset = p - begin;
+        const size_t limit = bounded ? nextRecordStart(data, offset + 1) : data.size();
+        auto range = matchJsonValue(p, limit - offset);
+        if (!range) {
+            const size_t next = nextRecordStart(data, offset + 1);
+            skipped(offset, next - offset);
+            p = begin + next;
+            bounded = true;
+            continue;
+        }
+
+        consumer(index, std::string_view(range->start, range->end - range->start));
+        p = range->end;
+        index++;
+    }
+}
+
+namespace
+{
+    const char RECORD_SEPARATOR = '\x1e';
+
+    bool isBlank(char c)
+    {
+        return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+    }
+
+    // `text` without surrounding whitespace
+    std::string_view trimmed(std::string_view text)
+    {
+        size_t first = 0;
+        while (first < text.size() && isBlank(text[first]))
+            ++first;
+        size_t last = text.size();
+        while (last > first && isBlank(text[last - 1]))
+            --last;
+        return text.substr(first, last - first);
+    }
+
+    // a UTF-8 byte order mark is no part of the records
+    size_t bomSize(std::string_view data)
+    {
+        return data.substr(0, 3) == "\xEF\xBB\xBF" ? 3 : 0;
+    }
+
+    size_t skipBlank(std::string_view data, size_t offset)
+    {
+        while (offset < data.size() && isBlank(data[offset]))
+            ++offset;
+        return offset;
+    }
+
+    // records are the non-blank lines, found with memchr only
+    void splitLines(std::string_view data, const std::function<void(size_t, std::string_view)>& consumer)
+    {
+        const char* p = data.data();
+        const char* end = p + data.size();
+        size_t index = 0;
+
+        while (p < end) {
+            const char* newline = static_cast<const char*>(std::memchr(p, '\n', end - p));
+            const char* lineEnd = newline ? newline : end;
+            auto line = trimmed(std::string_view(p, lineEnd - p));
+            if (!line.empty())
+                consumer(index++, line);
+            p = lineEnd + 1;
+        }
+    }
+
+    // records are the texts between RS characters
+    void splitSequence(std::string_view data, const std::function<void(size_t, std::string_view)>& consumer,
+                       const std::function<void(size_t, size_t)>& skipped)
+    {
+        const char* begin = data.data();
+        const char* end = begin + data.size();
+        size_t index = 0;
+
+        // anything before the first RS isn't part of the sequence
+        const char* p = static_cast<const char*>(std::memchr(begin, RECORD_SEPARATOR, end - begin));
+        if (!p)
+            p = end;
+        if (!trimmed(std::string_view(begin, p - begin)).empty())
+            skipped(0, p - begin);
+
+        while (p < end) {
+            const char* start = p + 1;
+            const char* next = static_cast<const char*>(std::memchr(start, RECORD_SEPARATOR, end - start));
+            if (!next)
+                next = end;
+            auto text = trimmed(std::string_view(start, next - start));
+            if (!text.empty())
+                consumer(index++, text);
+            p = next;
+        }
+    }
+
+    // records are the elements of the top-level array, matched one by one
+    void splitArray(std::string_view data, const std::function<void(size_t, std::string_view)>& consumer,
+                    const std::function<void(size_t, size_t)>& skipped)
+    {
+        size_t offset = skipBlank(data, 0);
+        if (offset == data.size() || data[offset] != '[') {
+            if (offset < data.size())
+                skipped(offset, data.size() - offset);
+            return;
+        }
+        offset = skipBlank(data, offset + 1);
+
+        size_t index = 0;
+        bool closed = offset < data.size() && data[offset] == ']';
+        while (!closed && offset < data.size()) {
+            auto range = matchJsonValue(data.data() + offset, data.size() - offset);
+            if (!range)
+                break;
+
+            consumer(index++, std::string_view(range->start, range->end - range->start));
+            offset = skipBlank(data, range->end - data.data());
+            if (offset < data.size() && data[offset] == ',') {
+                offset = skipBlank(data, offset + 1);
+            } else if (offset < data.size() && data[offset] == ']') {
+                closed = true;
+            } else {
+                break;
+            }
+        }
+
+        // elements can't be told apart after a broken one, the rest is skipped
+        if (!closed) {
+            if (offset < data.size())
+                skipped(offset, data.size() - offset);
+            return;
+        }
+
+        offset = skipBlank(data, offset + 1);
+        if (offset < data.size())
+            skipped(offset, data.size() - offset);
+    }
+}
+
+const char* formatName(JsonFormat format)
+{
+    switch (format) {
+        case JsonFormat::Lines: return "JSON Lines";
+        case JsonFormat::Array: return "JSON array";
+        case JsonFormat::Sequence: return "JSON text sequence";
+        case JsonFormat::Concatenated: return "Concatenated JSON";
+    }
+    return "";
+}
+
+JsonFormat detectJsonFormat(std::string_view data)
+{
+    const size_t start = skipBlank(data, bomSize(data));
+    if (start == data.size())
+        return JsonFormat::Lines;
+    if (data[start] == RECORD_SEPARATOR)
+        return JsonFormat::Sequence;
+
+    // NDJSON when the first line holds exactly one value
+    size_t lineEnd = data.find('\n', start);
+    if (lineEnd == std::string_view::npos)
+        lineEnd = data.size();
+    auto range = matchJsonValue(data.data() + start, lineEnd - start);
+    const bool oneLine = range && trimmed(std::string_view(range->end, data.data() + lineEnd - range->end)).empty();
+    const bool lastLine = skipBlank(data, lineEnd) == data.size();
+
+    if (data[start] == '[') {
+        // an array alone in the file, minified or not, holds the records
+        if (!oneLine || lastLine)
+            return JsonFormat::Array;
+        return JsonFormat::Lines;
+    }
+    return oneLine ? JsonFormat::Lines : JsonFormat::Concatenated;
+}
+
+void splitJson(std::string_view data, JsonFormat format, std::function<void(size_t, std::string_view)> consumer,
+               std::function<void(size_t, size_t)> skipped)
+{
+    const size_t bom = bomSize(data);
+    auto text = data.substr(bom);
+    auto shifted = [&](size_t offset, size_t length) { skipped(bom + offset, length); };
+
+    switch (format) {
+        case JsonFormat::Lines: splitLines(text, consumer); break;
+        case JsonFormat::Array: splitArray(text, consumer, shifted); break;
+        case JsonFormat::Sequence: splitSequence(text, consumer, shifted); break;
+        case JsonFormat::Concatenated: indexSequentialJson(text, consumer, shifted); break;
+    }
+}
+
 std::string toJsonStringPretty(const rapidjson::Value& value) {
     rapidjson::StringBuffer buffer;
     rapidjson::PrettyWriter<rapidjson::StringBuffer> writer(buffer);
@@ -4,6 +4,7 @@
 #include <string_view>
 #include <optional>
 #include <functional>
+#include <vector>
 
 struct Range
 {
@@ -11,9 +12,58 @@ struct Range
     const char* end;
 };
 
+// location of a value in the source text of a record.
+// Spans are stored in pre-order, so children of the value at `i` start at `i + 1`
+// and the next sibling is at `i + 1 + descendants`.
+struct JsonSpan
+{
+    size_t offset;
+    size_t length;
+    size_t descendants;
+};
+
+// source text of a parsed record and spans of all its values
+struct JsonSource
+{
+    std::string_view text;
+    const std::vector<JsonSpan>* spans = nullptr;
+
+    bool valid() const { return spans && !spans->empty(); }
+    const JsonSpan& span(size_t index) const { return (*spans)[index]; }
+    std::string_view slice(size_t index) const { return text.substr(span(index).offset, span(index).length); }
+};
+
 std::string toJsonString(const rapidjson::Value& value);
 std::string toJsonStringPretty(const rapidjson::Value& value);
 std::string toJsonString(const rapidjson::Value& value, size_t limit);
+// minified JSON `text` up to `limit` bytes, read without building a DOM
+std::string toJsonString(std::string_view text, size_t limit);
 std::optional<Range> matchJsonValue(const char* input, size_t length);
 
+// parse `text` into `doc`, recording the span of every value in a single pass
+bool parseWithSpans(std::string_view text, rapidjson::Document& doc, std::vector<JsonSpan>& spans);
+
 void parseSequentialJson(std::string_view data, std::function<void(size_t, std::string_view)> consumer);
+// like parseSequentialJson, but bytes that don't match a value are passed to `skipped` (offset, length)
+// and indexing resumes at the next line starting with { or [, the next record of NDJSON
+void indexSequentialJson(std::string_view data, std::function<void(size_t, std::string_view)> consumer,
+                         std::function<void(size_t, size_t)> skipped);
+// offset of the next line starting with { or [ after `from`, or the size of the data
+size_t nextRecordStart(std::string_view data, size_t from);
+
+// how the records of a file are laid out
+enum class JsonFormat
+{
+    Lines,          // NDJSON, one value per line
+    Array,          // one top-level array, its elements are the records
+    Sequence,       // RFC 7464 JSON text sequence, values start with RS (0x1E)
+    Concatenated,   // values one after another, e.g. pretty printed objects
+};
+
+const char* formatName(JsonFormat format);
+// guessed from the first values of the data
+JsonFormat detectJsonFormat(std::string_view data);
+// records of `data` in `format`, skipped bytes are reported like by indexSequentialJson.
+// Lines and sequences are split without matching brackets, broken records show up when parsed.
+void splitJson(std::string_view data, JsonFormat format, std::function<void(size_t, std::string_view)> consumer,
+               std::function<void(size_t, size_t)> skipped);
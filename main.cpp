@@ -3,18 +3,69 @@
 #include <QTimer>
 
 #include "MainWindow.h"
+#include "Diagnostics.h"
+
+#include <cstring>
+#include <iostream>
+#include <memory>
+
+// parses every record of the files and prints the diagnostics report
+static int dumpDiagnostics(const QStringList& files)
+{
+    JsonFile jsonFile;
+    rapidjson::Document doc;
+    std::vector<JsonSpan> spans;
+
+    // the memory part of the report covers the last file
+    for (const QString& file : files) {
+        jsonFile.close();
+        if (!jsonFile.open(file)) {
+            std::cerr << "cannot open " << file.toStdString() << std::endl;
+            return 1;
+        }
+
+        for (size_t i = 0; i < jsonFile.size(); ++i)
+            jsonFile.parseLine(i, doc, spans);
+    }
+
+    std::cout << diagnostics::report(files.isEmpty() ? nullptr : &jsonFile) << std::endl;
+    return 0;
+}
 
 int main(int argc, char *argv[]) {
-    QApplication app(argc, argv);
+    // the report is printed without creating any window
+    bool headless = false;
+    for (int i = 1; i < argc; ++i)
+        headless = headless || std::strcmp(argv[i], "--diagnostics") == 0;
+
+    std::unique_ptr<QCoreApplication> app(headless ? new QCoreApplication(argc, argv) : new QApplication(argc, argv));
     QCommandLineParser parser;
 
     parser.addHelpOption();
     parser.addPositionalArgument("file", "File to open");
+
+    QCommandLineOption bucketSizeOption("bucket-size",
+        "Group tree children into ranges of <size> items, 0 disables grouping.", "size", QString::number(TREE_BUCKET_SIZE));
+    parser.addOption(bucketSizeOption);
+
+    QCommandLineOption memoryOption("memory-budget",
+        "Megabytes for parsed records, table cells and trees, 0 picks half of the available memory.", "MB", "0");
+    parser.addOption(memoryOption);
+
+    QCommandLineOption diagnosticsOption("diagnostics",
+        "Parse all records of the files and print the diagnostics as JSON.");
+    parser.addOption(diagnosticsOption);
+
     parser.process(QCoreApplication::arguments());
 
     const QStringList files = parser.positionalArguments();
 
+    if (parser.isSet(diagnosticsOption))
+        return dumpDiagnostics(files);
+
     MainWindow window;
+    window.setTreeBucketSize(parser.value(bucketSizeOption).toULongLong());
+    window.setMemoryBudget(parser.value(memoryOption).toULongLong() * 1024 * 1024);
     window.resize(1000, 700);
     window.show();
 
@@ -23,5 +74,5 @@ int main(int argc, char *argv[]) {
     });
     // window.processArguments(files);
 
-    return app.exec();
+    return app->exec();
 }
@@ -1,8 +0,0 @@
-#pragma once
-
-#include "constants.h"
-
-#include <QTreeView>
-#include <QModelIndex>
-
-void openEditorsRecursive(QTreeView* view, const QModelIndex& parent = QModelIndex());